@@ -8,10 +8,14 @@
 #include "inc/NeoPixel.h"
 #include "inc/LightRelay.h"
 #include "inc/WebServer.h"
+#include "inc/StaticAsset.h"
 #include "inc/DataPointManager.h"
+#include "inc/History.h"
+#include "inc/EventStream.h"
+#include "inc/SettingStore.h"
+#include "inc/DNSServer.h"
 #include <limits.h>
 #include <Preferences.h>
-#include <DNSServer.h>
 
 #define LED_PIN 16
 #define LED_COUNT 26
@@ -22,6 +26,25 @@
 
 #define RELAY_PIN 4
 
+#define DISTANCE_HISTORY_BLOCKS 24 //128 bytes each, ~60-120 readings per block
+#define DISTANCE_HISTORY_SECONDS 120
+#define DISTANCE_HISTORY_MINUTES 60
+
+#define MAX_DATA_POINTS 32
+
+#define SETTINGS_DEBOUNCE 2000 //ms without changes before settings are written to flash
+#define SETTINGS_MAX_DELAY 10000 //Longest ms a changed setting waits to be written
+
+#define MAX_EVENT_CLIENTS 4
+#define EVENT_MIN_INTERVAL 250 //Minimum ms between event updates of a data point
+#define MAX_SAMPLE_CLIENTS 2 //WebSocket clients streaming raw samples
+
+#ifndef HTTP_RATE_LIMIT
+#define HTTP_RATE_LIMIT 10 //Requests a second each client IP can make on average, 0 turns it off (the host benchmark's build)
+#endif //HTTP_RATE_LIMIT
+#define HTTP_RATE_BURST 20 //Requests a client IP can make at once (ie loading the page)
+#define HTTP_TIME_BUDGET 20000 //Most us spent handling requests per loop, the rest waits for the next loop
+
 enum class Mode : uint8_t{
   REGULAR = 0,
   SELECT = 1,
@@ -51,7 +74,8 @@ namespace Error{
 
 //Preferences keys
 const char *wifiPswdKey = "wifiPswd";
-const char *thresholdKey = "threshold";
+const char *thresholdKey = "threshold"; //Only read to bring over the value saved by older firmware
+const char *settingsKey = "settings";
 
 //Features of this build
 uint32_t features = (HAS_COLOR ? Feature::COLOR : Feature::NONE) | Feature::WIFI;
@@ -81,28 +105,63 @@ Light &light = relay;
 #endif
 
 DNSServer dnsServer{};
+//Background traffic from phones and laptops on the AP, NXDOMAIN makes them back off instead of
+//retrying against us, the portal checks (connectivitycheck.gstatic.com, captive.apple.com, ...) still resolve to us
+const char *const DNS_BLOCKED[] = {
+  "*.windowsupdate.com", "*.update.microsoft.com", "*.delivery.mp.microsoft.com", "*.events.data.microsoft.com",
+  "settings-win.data.microsoft.com", "mesu.apple.com", "xp.apple.com", "*.metrics.icloud.com",
+  "app-measurement.com", "firebaselogging-pa.googleapis.com", "play.googleapis.com"
+};
 WebServer server{80, "stop.light"};
 const char* MAIN_HTML_DATA = 
 #include "data/main.string"
 ;
+const uint8_t MAIN_HTML_GZIP[] = {
+#include "data/main.gz.bytes"
+};
+const char* MAIN_HTML_ETAG = 
+#include "data/main.etag.string"
+;
+const char* MAIN_HTML_GZIP_ETAG = 
+#include "data/main.gz.etag.string"
+;
 const char* favicon = 
 #include "data/favicon.string"
 ;
+const uint8_t FAVICON_GZIP[] = {
+#include "data/favicon.gz.bytes"
+};
+const char* FAVICON_ETAG = 
+#include "data/favicon.etag.string"
+;
+const char* FAVICON_GZIP_ETAG = 
+#include "data/favicon.gz.etag.string"
+;
+//The page is checked with the ETag on every load so a firmware update shows up right away
+const StaticAsset mainPage     {"text/html",     "no-cache",       MAIN_HTML_DATA, MAIN_HTML_GZIP, sizeof(MAIN_HTML_GZIP), MAIN_HTML_ETAG, MAIN_HTML_GZIP_ETAG};
+const StaticAsset faviconAsset {"image/svg+xml", "max-age=604800", favicon,        FAVICON_GZIP,   sizeof(FAVICON_GZIP),   FAVICON_ETAG,   FAVICON_GZIP_ETAG  };
 
 const String wifiSSID = "stoplight_" + Net::getChipID();
 String wifiPswd = "lightpass";
+String wifiPswdBefore; //Password the AP had before an unconfirmed change, put back if nobody connects in time
 
 TOFSensor::distance_t curDistance;
+History<DISTANCE_HISTORY_BLOCKS, DISTANCE_HISTORY_SECONDS, DISTANCE_HISTORY_MINUTES> distanceHistory;
 Time curTime;
 Mode curMode = Mode::REGULAR;
+uint32_t loopMaxUs = 0; //Longest loop() took (LOOP_DELAY left out), set to 0 to start over
 
-DataPointManager dataPoints{};
+DataPointManager<MAX_DATA_POINTS> dataPoints{};
+EventStream<MAX_EVENT_CLIENTS, MAX_DATA_POINTS> events{EVENT_MIN_INTERVAL};
+WebSocketStream<MAX_SAMPLE_CLIENTS> sampleStream;
 
 Preferences prefs;
+SettingStore<MAX_DATA_POINTS> settings{prefs, settingsKey, SETTINGS_DEBOUNCE, SETTINGS_MAX_DELAY};
 
 bool setWifiPswd(const String& pswd){
   if(WiFi.getMode() == WIFI_MODE_AP){
     if(Net::createNetwork(wifiSSID, pswd)){
+      if(wifiPswdChangeTime == Time::NULL_TIME){ wifiPswdBefore = wifiPswd; } //Not a change of a change
       wifiPswd = pswd;
       wifiPswdChangeTime = Time::now(false);
       return true;
@@ -114,9 +173,7 @@ bool setWifiPswd(const String& pswd){
   return true;
 }
 
-DataPoint::status_t setWifiPswdCallback(DataPoint::data_t data, DataPoint::Type type){
-  if(type != DataPoint::STR){ return DataPoint::BAD; }
-  String pswd = *static_cast<String*>(data);
+DataPoint::status_t setWifiPswdCallback(const String &pswd){
   if(!setWifiPswd(pswd)){ return DataPoint::BAD; }
   return DataPoint::SET | DataPoint::OK;
 }
@@ -128,13 +185,10 @@ bool setThreshold(TOFSensor::distance_t distance){
   triggerZone.upper = distance;
   triggerZone.lower = distance < rangingZone ? 0 : (distance - rangingZone);
   leaveZone.lower = distance + 1;
-  prefs.putUShort(thresholdKey, triggerZone.upper);
   return true;
 }
 
-DataPoint::status_t setThresholdCallback(DataPoint::data_t data, DataPoint::Type type){
-  if(type != DataPoint::UINT || data == nullptr){ return DataPoint::BAD; }
-  uint32_t newThresh = *static_cast<uint32_t*>(data);
+DataPoint::status_t setThresholdCallback(const TOFSensor::distance_t &newThresh){
   bool threshSet = setThreshold(newThresh);
   DataPoint::status_t status = threshSet ? (DataPoint::OK | DataPoint::SET) : DataPoint::BAD;
   return status;
@@ -156,89 +210,327 @@ void setMode(Mode newMode){
   curMode = newMode;
 }
 
-DataPoint::status_t setModeCallback(DataPoint::data_t data, DataPoint::Type type){
-  if(type != DataPoint::UINT8 || data == nullptr){ return DataPoint::BAD; }
-  uint8_t newModeInt = *static_cast<uint8_t*>(data);
-  if(newModeInt > MAX_MODE){ return DataPoint::BAD; }
+DataPoint::status_t setModeCallback(const Mode &newMode){
+  if(static_cast<uint8_t>(newMode) > MAX_MODE){ return DataPoint::BAD; }
 
   DataPoint::status_t status = DataPoint::OK;
-  Mode newMode = static_cast<Mode>(newModeInt);
   setMode(newMode);
   status |= DataPoint::SET;
   return status;
 }
 
-void mainPageCallback(WiFiClient& client, WebPath::method_t method, const String& vars){
-  Net::sendHeader(client, Net::HTTP_RES_OK, "text/html");
-  client.print(MAIN_HTML_DATA);
+void mainPageCallback(Response& res, const HttpRequest& req){
+  mainPage.send(res, req);
 }
 
 //Body will contain new value if set
-void setPageCallback(WiFiClient& client, WebPath::method_t method, const String& vars){
-  String dataPointName {Net::getKeyValue("dp", vars)};
-  String value {Net::getKeyValue("val", vars)};
-  if(dataPointName.isEmpty() || value.isEmpty()){
-    Net::sendHeaderAndBody(client, Net::HTTP_RES_BAD_REQ);
+void setPageCallback(Response& res, const HttpRequest& req){
+  StrView name {req.param("dp")};
+  StrView value {req.param("val")};
+  if(name.empty() || value.empty()){
+    res.send(Net::HTTP_RES_BAD_REQ);
     return;
   }
 
-  if(dataPoints.set(dataPointName, value) == DataPoint::BAD){ //Invalid value
-    Net::sendHeaderAndBody(client, Net::HTTP_RES_BAD_REQ); 
+  if(dataPoints.set(name.data, name.len, value.toString()) == DataPoint::BAD){ //Invalid value
+    res.send(Net::HTTP_RES_BAD_REQ); 
+    return;
+  }
+
+  char newValue[DataPoint::MAX_STR_LEN + 1];
+  dataPoints.get(name.data, name.len).toChars(newValue, sizeof(newValue), true);
+  res.begin(Net::HTTP_RES_OK, "text/plain");
+  res.println(newValue);
+}
+
+//Sets several data points in one request, the parameters are name=value pairs
+//Every value is validated before any of them are set, if one is bad nothing is set
+//They are then set in order, if one is still rejected (ie by its set callback) the ones set before it are put back
+//to their old values, so either all of them are set or none
+//wifiPswd can't be set here, its callback brings the network back up, which a roll back would do a second time
+//Body is a JSON object with an object for each parameter containing
+//  s: status (see DataPoint::VerifyStatus), 0 if it wasn't set (or was put back) because another value was bad
+//  val: value of the data point after the request, null if there is no data point with that name
+extern TypedDataPoint<String> wifiPswdDp;
+void setManyPageCallback(Response& res, const HttpRequest& req){
+  const uint8_t MAX_BATCH = 8;
+  struct Item{
+    StrView name;
+    DataPoint *dp;
+    String value;
+    DataPoint::status_t status;
+    uint8_t old[DataPoint::MAX_BYTES]; //Value before it was set, to put it back
+    size_t oldLen;
+  } items[MAX_BATCH];
+  uint8_t itemCount = 0;
+  bool allValid = true;
+  //Validate
+  if(req.paramCount() > MAX_BATCH || req.paramsDropped()){
+    res.send(Net::HTTP_RES_BAD_REQ);
+    return;
+  }
+  for(uint8_t i = 0; i < req.paramCount(); ++i){
+    Item &item = items[itemCount++];
+    item.name = req.paramName(i);
+    item.dp = dataPoints.find(item.name.data, item.name.len);
+    item.value = req.paramValue(i).toString();
+    bool valid = item.dp != nullptr && item.dp->settable && item.dp != &wifiPswdDp && !item.value.isEmpty() &&
+                 item.dp->validateData(item.value);
+    item.status = valid ? 0 : DataPoint::BAD;
+    allValid &= valid;
+  }
+  if(itemCount == 0){
+    res.send(Net::HTTP_RES_BAD_REQ);
     return;
   }
+  //Apply
+  uint8_t applied = 0;
+  for(; allValid && applied < itemCount; ++applied){
+    Item &item = items[applied];
+    item.oldLen = item.dp->toBytes(item.old, sizeof(item.old));
+    item.status = item.dp->setValueStr(item.value);
+    allValid = item.status != DataPoint::BAD;
+  }
+  //Roll back, newest first so a data point given twice ends up with its value from before the request
+  if(!allValid){
+    while(applied-- > 0){
+      Item &item = items[applied];
+      if(item.status == DataPoint::BAD){ continue; }
+      if(item.dp->setValueBytes(item.old, item.oldLen) == DataPoint::BAD){
+        print("Couldn't put back ");
+        println(item.dp->name);
+      }
+      item.status = 0;
+    }
+  }
+  //Respond
+  res.begin(allValid ? Net::HTTP_RES_OK : Net::HTTP_RES_BAD_REQ, "application/json");
+  char buf[Net::SEND_BUF_BYTES];
+  JsonWriter json{res, buf, sizeof(buf)};
+  json.beginObject();
+  for(uint8_t i = 0; i < itemCount; ++i){
+    json.key(items[i].name.data, items[i].name.len);
+    json.beginObject();
+    json.key("s");
+    json.value(static_cast<uint32_t>(items[i].status));
+    json.key("val");
+    if(items[i].dp == nullptr){ json.raw("null", 4); }
+    else{
+      char value[DataPoint::MAX_STR_LEN + 1];
+      size_t len = items[i].dp->toChars(value, sizeof(value), true);
+      json.value(value, len < sizeof(value) ? len : sizeof(value) - 1);
+    }
+    json.endObject();
+  }
+  json.endObject();
+  json.flush();
+}
 
-  Net::sendHeader(client, Net::HTTP_RES_OK, "text/plain");
-  client.println(dataPoints.get(dataPointName).toString(true));
+//Whether the client asked for CBOR instead of text/JSON
+//Either with fmt=cbor or an Accept header containing application/cbor
+bool wantsCBOR(const HttpRequest &req){
+  StrView fmt {req.param("fmt")};
+  if(fmt.data != nullptr){ return fmt.equals("cbor"); }
+  return req.header("Accept").contains(Net::CONTENT_CBOR);
 }
 
-//Body contains only teh value of teh datapoint
-void getPageCallback(WiFiClient& client, WebPath::method_t method, const String& vars){
-  String dataPointName {Net::getKeyValue("dp", vars)};
-  if(dataPointName.isEmpty()){
-    Net::sendHeaderAndBody(client, Net::HTTP_RES_BAD_REQ);
+//Body contains only teh value of teh datapoint (a single CBOR item if CBOR was asked for)
+void getPageCallback(Response& res, const HttpRequest& req){
+  StrView name {req.param("dp")};
+  if(name.empty()){
+    res.send(Net::HTTP_RES_BAD_REQ);
     return;
   }
-  const DataPoint& dp {dataPoints.get(dataPointName)};
+  const DataPoint& dp {dataPoints.get(name.data, name.len)};
   if(dp == DataPoint::NULL_DATAPOINT){
-    Net::sendHeaderAndBody(client, Net::HTTP_RES_BAD_REQ);
+    res.send(Net::HTTP_RES_BAD_REQ);
+    return;
+  }
+  if(wantsCBOR(req)){
+    res.begin(Net::HTTP_RES_OK, Net::CONTENT_CBOR);
+    uint8_t buf[DataPoint::MAX_STR_LEN + 16];
+    CborWriter cbor{res, buf, sizeof(buf)};
+    dp.writeCBORValue(cbor);
+    cbor.flush();
+    return;
+  }
+  char value[DataPoint::MAX_STR_LEN + 1];
+  dp.toChars(value, sizeof(value), true);
+  res.begin(Net::HTTP_RES_OK, "text/plain");
+  res.println(value);
+}
+
+//Json object of all datapoints, plus "seq" which holds the current change sequence number
+//f can be set to a comma separated list of filters, only data points matching all of them are sent
+//See DataPoint::Filter::parseString for the format
+//since can be set to a sequence number from an earlier response, only data points changed after it are sent
+//Without since every data point is sent, including ones that haven't changed since boot
+//The same structure is sent as a CBOR map if CBOR was asked for (see wantsCBOR)
+void getAllPageCallback(Response& res, const HttpRequest& req){
+  uint64_t sinceVal = 0;
+  StrView sinceStr {req.param("since")};
+  if(!sinceStr.empty() && (!sinceStr.toUInt(sinceVal) || sinceVal > UINT32_MAX)){
+    res.send(Net::HTTP_RES_BAD_REQ);
+    return;
+  }
+  DataPoint::seq_t since = sinceVal;
+  bool delta = !sinceStr.empty();
+  DataPoint::Filter filters[DataPoint::Filter::MAX_FILTERS];
+  uint8_t filterCount = 0;
+  StrView filterStr {req.param("f")};
+  if(!filterStr.empty()){
+    filterCount = DataPoint::Filter::parseMultiString(filterStr.toString(), filters, DataPoint::Filter::MAX_FILTERS);
+    if(filterCount == 0){
+      res.send(Net::HTTP_RES_BAD_REQ);
+      return;
+    }
+  }
+  uint16_t dpCount = dataPoints.count();
+  if(wantsCBOR(req)){
+    res.begin(Net::HTTP_RES_OK, Net::CONTENT_CBOR);
+    uint8_t buf[Net::SEND_BUF_BYTES];
+    CborWriter cbor{res, buf, sizeof(buf)};
+    cbor.beginMap();
+    cbor.key("seq");
+    cbor.value(DataPoint::curSeq());
+    for(uint16_t i = 0; i < dpCount; ++i){
+      const DataPoint &dp {dataPoints.get(i)};
+      if((!delta || dp.changedSince(since)) && dp.matchesFilters(filters, filterCount)){ dp.writeCBOR(cbor); }
+    }
+    cbor.end();
+    cbor.flush();
+    return;
+  }
+  res.begin(Net::HTTP_RES_OK, "application/json");
+  char buf[Net::SEND_BUF_BYTES];
+  JsonWriter json{res, buf, sizeof(buf)};
+  json.beginObject();
+  json.key("seq");
+  json.value(DataPoint::curSeq());
+  for(uint16_t i = 0; i < dpCount; ++i){
+    const DataPoint &dp {dataPoints.get(i)};
+    if((!delta || dp.changedSince(since)) && dp.matchesFilters(filters, filterCount)){ dp.writeJSON(json, true); }
+  }
+  json.endObject();
+  json.flush();
+}
+
+//JSON object with the history of a data point that keeps one (see HistoryBase::writeJSON)
+//dp is the data point, from (optional) is the earliest time (ms since boot) to send
+void historyPageCallback(Response& res, const HttpRequest& req){
+  StrView name {req.param("dp")};
+  const DataPoint &dp {dataPoints.get(name.data, name.len)};
+  uint64_t fromMs = 0;
+  StrView fromStr {req.param("from")};
+  if(name.empty() || dp.history == nullptr || (!fromStr.empty() && !fromStr.toUInt(fromMs))){
+    res.send(Net::HTTP_RES_BAD_REQ);
+    return;
+  }
+  Time from {static_cast<Time::Time_t>(fromMs)};
+  res.begin(Net::HTTP_RES_OK, "application/json");
+  char buf[Net::SEND_BUF_BYTES];
+  JsonWriter json{res, buf, sizeof(buf)};
+  json.beginObject();
+  json.key("dp");
+  json.value(dp.name, dp.nameLen);
+  json.key("now");
+  json.value(static_cast<uint64_t>(Time::now(false).raw));
+  dp.history->writeJSON(json, from);
+  json.endObject();
+  json.flush();
+}
+
+//DNS server stats as JSON (see DNSServer::writeJSON)
+void dnsPageCallback(Response& res, const HttpRequest& req){
+  res.begin(Net::HTTP_RES_OK, "application/json");
+  char buf[Net::SEND_BUF_BYTES];
+  JsonWriter json{res, buf, sizeof(buf)};
+  dnsServer.writeJSON(json);
+  json.flush();
+}
+
+//Server-Sent Events stream of data point changes (see EventStream)
+//The client is kept open and gets a "dp" event with every data point, then one whenever some change
+void eventsPageCallback(Response& res, const HttpRequest& req){
+  if(!events.subscribe(res.client(), dataPoints)){
+    res.send(Net::HTTP_RES_UNAVAILABLE);
     return;
   }
-  Net::sendHeader(client, Net::HTTP_RES_OK, "text/plain");
-  client.println(dp.toString(true));
+  server.detachClient();
 }
 
-//Json array of all datapoints
-void getAllPageCallback(WiFiClient& client, WebPath::method_t method, const String& vars){
-  Net::sendHeader(client, Net::HTTP_RES_OK, "application/json");
-  client.println('{');
-  uint8_t dpCount = dataPoints.count();
-  for(uint8_t i = 0; i < dpCount - 1; ++i){
-    client.print(dataPoints.get(i).toJSON(true));
-    client.println(',');
-  }
-  client.println(dataPoints.get(dpCount-1).toJSON(true));
-  client.println('}');
+//WebSocket that gets a binary message for every sensor reading (see recordDistance)
+void samplesPageCallback(Response& res, const HttpRequest& req){
+  if(!sampleStream.hasRoom()){
+    res.send(Net::HTTP_RES_UNAVAILABLE);
+    return;
+  }
+  if(!server.acceptWebSocket(res.client(), req)){
+    res.send(Net::HTTP_RES_BAD_REQ);
+    return;
+  }
+  sampleStream.add(res.client());
 }
 
-void tryColorCallback(WiFiClient& client, WebPath::method_t method, const String& vars){
-  String value {Net::getKeyValue("val", vars)};
-  if(value.isEmpty() || !isInt(value, false)){
-    Net::sendHeaderAndBody(client, Net::HTTP_RES_BAD_REQ);
+void tryColorCallback(Response& res, const HttpRequest& req){
+  uint64_t value = 0;
+  if(!req.param("val").toUInt(value) || value > UINT32_MAX){
+    res.send(Net::HTTP_RES_BAD_REQ);
     return;
   }
-  uint32_t newColor = toInt(value);
+  uint32_t newColor = value;
   lightStrip.show(newColor);
-  Net::sendHeader(client, Net::HTTP_RES_OK, "text/plain");
-  client.println(newColor);
+  res.begin(Net::HTTP_RES_OK, "text/plain");
+  res.println(newColor);
 }
 
-void sendFavicon(WiFiClient &client, uint8_t method, const String &vars){
+void sendFavicon(Response &res, const HttpRequest &req){
   if(favicon == nullptr || favicon[0] == '\0'){
-    Net::sendHeaderAndBody(client, Net::HTTP_RES_NOT_FOUND);
+    res.send(Net::HTTP_RES_NOT_FOUND);
     return;
   }
-  Net::sendHeader(client, Net::HTTP_RES_OK, "image/svg+xml");
-  client.print(favicon);
+  faviconAsset.send(res, req);
+}
+
+//Data points
+//                                    Name            Variable                    Settable  Verify/Set Func       Persistent
+TypedDataPoint<TOFSensor::distance_t> distanceDp    {"distance",     &curDistance                                                         };
+TypedDataPoint<Time>                  uptimeDp      {"uptime",       &curTime                                                             };
+TypedDataPoint<uint32_t>              featuresDp    {"features",     &features                                                            };
+TypedDataPoint<uint32_t>              errorsDp      {"errors",       &errors                                                              };
+TypedDataPoint<Mode>                  modeDp        {"mode",         &curMode,                   true,     setModeCallback,      true   };
+TypedDataPoint<TOFSensor::distance_t> thresholdDp   {"threshold",    &triggerZone.upper,         true,     setThresholdCallback, true   };
+TypedDataPoint<NeoPixel::color_t>     colorDp       {"color",        &lightStrip.color,          true,     nullptr,              true   };
+TypedDataPoint<String>                wifiPswdDp    {"wifiPswd",     &wifiPswd,                  true,     setWifiPswdCallback          };
+TypedDataPoint<uint32_t>              flashWritesDp {"flashWrites",  &settings.stats().writes                                             };
+TypedDataPoint<uint32_t>              flashSkipsDp  {"flashSkips",   &settings.stats().skipped                                            };
+TypedDataPoint<uint32_t>              flashTimeDp   {"flashWriteUs", &settings.stats().writeTime                                          };
+//Connection reuse rate is httpReused / httpReqs, TCP segments per response is httpSegments / httpReqs
+TypedDataPoint<uint32_t>              httpConnsDp   {"httpConns",    &server.stats().connections                                          };
+TypedDataPoint<uint32_t>              httpReqsDp    {"httpReqs",     &server.stats().requests                                             };
+TypedDataPoint<uint32_t>              httpReusedDp  {"httpReused",   &server.stats().reused                                               };
+TypedDataPoint<uint32_t>              httpSegmentsDp{"httpSegments", &server.responseStats().segments                                     };
+TypedDataPoint<uint32_t>              httpChunkedDp {"httpChunked",  &server.responseStats().chunked                                      };
+TypedDataPoint<uint32_t>              httpLimitedDp {"httpLimited",  &server.stats().limited                                              };
+TypedDataPoint<uint32_t>              httpDeferredDp{"httpDeferred", &server.stats().deferred                                             };
+TypedDataPoint<uint32_t>              loopMaxDp     {"loopMaxUs",    &loopMaxUs,                 true                                     };
+//Mean DNS handling time is dnsHandlerUs / dnsQueries, the breakdown by type, code and name is at /dns
+TypedDataPoint<uint32_t>              dnsQueriesDp  {"dnsQueries",   &dnsServer.stats().queries                                           };
+TypedDataPoint<uint32_t>              dnsCachedDp   {"dnsCached",    &dnsServer.stats().cached                                            };
+TypedDataPoint<uint32_t>              dnsNxDomainDp {"dnsNxDomain",  &dnsServer.stats().nxDomain                                          };
+TypedDataPoint<uint32_t>              dnsTimeDp     {"dnsHandlerUs", &dnsServer.stats().handlerTime                                       };
+TypedDataPoint<uint32_t>              dnsMaxTimeDp  {"dnsMaxUs",     &dnsServer.stats().maxHandlerTime                                    };
+
+//Records every sensor reading and streams it to the /ws clients
+//Each message is 10 bytes, little endian: time (ms since boot, 8 bytes) then distance (mm, 2 bytes)
+void recordDistance(TOFSensor::distance_t distance){
+  Time now = Time::now(false);
+  distanceHistory.add(now, distance);
+  uint8_t sample[10];
+  for(uint8_t i = 0; i < 8; ++i){ sample[i] = static_cast<uint8_t>(now.raw >> (i * 8)); }
+  sample[8] = static_cast<uint8_t>(distance);
+  sample[9] = static_cast<uint8_t>(distance >> 8);
+  sampleStream.sendBinary(sample, sizeof(sample));
 }
 
 void handleRegular(){
@@ -280,10 +572,14 @@ void handleLight(){
 
 void handleNet(){
   server.processReq();
+  events.poll(dataPoints);
+  sampleStream.poll();
   if(wifiPswdChangeTime != Time::NULL_TIME){
     if(Time::timeSince(wifiPswdChangeTime) > WIFI_PSWD_CHANGE_TIMEOUT){
       wifiPswdChangeTime = Time::NULL_TIME;
-      wifiPswd = prefs.getString(wifiPswdKey);
+      //Not from prefs, it is only written once a device connects so it may not be there at all
+      wifiPswd = wifiPswdBefore;
+      Net::createNetwork(wifiSSID, wifiPswd);
     }
   }
 }
@@ -297,23 +593,18 @@ void onWifiEvent(WiFiEvent_t event){
   }
 }
 
+//Nothing is written here, missing or bad values just leave the defaults in place
 void loadPreferences(){
-  //Wifi password
+  //Wifi password (written once a device connects with it, see onWifiEvent)
   if(prefs.isKey(wifiPswdKey)){
     String pswd = prefs.getString(wifiPswdKey);
     if(Net::isValidPswd(pswd)){ wifiPswd = pswd; }
-    else{ prefs.putString(wifiPswdKey, wifiPswd); }
   }
-  else{
-    prefs.putString(wifiPswdKey, wifiPswd);
-  }
-  //Threshold
-  if(prefs.isKey(thresholdKey)){
-    uint32_t thresh = prefs.getUShort(thresholdKey);
-    if(!setThreshold(thresh)){ prefs.putUShort(thresholdKey, triggerZone.upper); }
-  }
-  else{
-    prefs.putUShort(thresholdKey, triggerZone.upper);
+  //Persistent data points, needs them added to dataPoints and the light initialized (mode and color show right away)
+  if(!settings.load(dataPoints)){ //Nothing saved yet, bring over what older firmware saved
+    if(prefs.getType(thresholdKey) == PT_U16){ setThreshold(prefs.getUShort(thresholdKey)); }
+    prefs.remove(thresholdKey);
+    settings.markDirty();
   }
 }
 
@@ -323,18 +614,45 @@ void setup() {
   Serial.begin(9600);
   println("Init Serial");
   #endif
-  //Preferences
-  if(!prefs.begin("stoplight", false)){
-    errors |= Error::PREFERENCES_ERR;
-    println("Error initializing preferences");
-  }
-  else{ loadPreferences(); }
   //Light
   if(!light.init()){
     errors |= Error::LIGHT_INIT_ERR;
     println("Error initializing light");
   }
+  //Data Points
+  distanceDp.history = &distanceHistory;
+  dataPoints.add(distanceDp);
+  dataPoints.add(uptimeDp);
+  dataPoints.add(featuresDp);
+  dataPoints.add(errorsDp);
+  dataPoints.add(modeDp);
+  dataPoints.add(thresholdDp);
+  dataPoints.add(colorDp);
+  dataPoints.add(wifiPswdDp);
+  dataPoints.add(flashWritesDp);
+  dataPoints.add(flashSkipsDp);
+  dataPoints.add(flashTimeDp);
+  dataPoints.add(httpConnsDp);
+  dataPoints.add(httpReqsDp);
+  dataPoints.add(httpReusedDp);
+  dataPoints.add(httpSegmentsDp);
+  dataPoints.add(httpChunkedDp);
+  dataPoints.add(httpLimitedDp);
+  dataPoints.add(httpDeferredDp);
+  dataPoints.add(loopMaxDp);
+  dataPoints.add(dnsQueriesDp);
+  dataPoints.add(dnsCachedDp);
+  dataPoints.add(dnsNxDomainDp);
+  dataPoints.add(dnsTimeDp);
+  dataPoints.add(dnsMaxTimeDp);
+  //Preferences (before the sensor so the threshold is in place)
+  if(!prefs.begin("stoplight", false)){
+    errors |= Error::PREFERENCES_ERR;
+    println("Error initializing preferences");
+  }
+  else{ loadPreferences(); }
   //TOF
+  tofSensor.onSample(recordDistance);
   if(!tofSensor.init()){
     errors |= Error::TOF_INIT_ERR;
     println("Error initializing sensor");
@@ -346,30 +664,29 @@ void setup() {
       waitForLeave = true;
     }
   }
-  //Data Points
-  //              Name              Variable            Type              Settable  Verify/Set Func
-  dataPoints.add({"distance",       &curDistance,       DataPoint::UINT,  false                             });
-  dataPoints.add({"uptime",         &curTime,           DataPoint::TIME,  false                             });
-  dataPoints.add({"features",       &features,          DataPoint::UINT,  false                             });
-  dataPoints.add({"errors",         &errors,            DataPoint::UINT,  false                             });
-  dataPoints.add({"mode",           &curMode,           DataPoint::UINT8, true,     setModeCallback         });
-  dataPoints.add({"threshold",      &triggerZone.upper, DataPoint::UINT,  true,     setThresholdCallback    });
-  dataPoints.add({"color",          &lightStrip.color,  DataPoint::UINT,  true                              });
-  dataPoints.add({"wifiPswd",       &wifiPswd,          DataPoint::STR,   true,     setWifiPswdCallback     });
   //Net
   if(features & Feature::WIFI){
     WiFi.begin();
     WiFi.onEvent(onWifiEvent);
     if(Net::createNetwork(wifiSSID, wifiPswd)){
       server.begin();
-      //              Path            Callback            Allowed Methods
-      server.addPath({"/",            mainPageCallback,   WebPath::GET});
-      server.addPath({"/favicon.ico", sendFavicon,        WebPath::GET});
-      server.addPath({"/get",         getPageCallback,    WebPath::GET});
-      server.addPath({"/getall",      getAllPageCallback, WebPath::GET});
-      server.addPath({"/set",         setPageCallback,    WebPath::POST});
-      server.addPath({"/trycolor",    tryColorCallback,   WebPath::POST});
-      if(!dnsServer.start()){
+      server.collectHeader("Accept");
+      server.setRateLimit(HTTP_RATE_LIMIT, HTTP_RATE_BURST);
+      server.setTimeBudget(HTTP_TIME_BUDGET);
+      //              Path            Callback             Allowed Methods
+      server.addPath({"/",            mainPageCallback,    WebPath::GET});
+      server.addPath({"/favicon.ico", sendFavicon,         WebPath::GET});
+      server.addPath({"/get",         getPageCallback,     WebPath::GET});
+      server.addPath({"/getall",      getAllPageCallback,  WebPath::GET});
+      server.addPath({"/set",         setPageCallback,     WebPath::POST});
+      server.addPath({"/setmany",     setManyPageCallback, WebPath::POST});
+      server.addPath({"/trycolor",    tryColorCallback,    WebPath::POST});
+      server.addPath({"/history",     historyPageCallback, WebPath::GET});
+      server.addPath({"/events",      eventsPageCallback,  WebPath::GET});
+      server.addPath({"/ws",          samplesPageCallback, WebPath::GET});
+      server.addPath({"/dns",         dnsPageCallback,     WebPath::GET});
+      for(const char *domain : DNS_BLOCKED){ dnsServer.addNXDomain(domain); }
+      if(!dnsServer.start(WiFi.softAPIP())){
         errors |= Error::DNS_ERR;
         println("Error creating DNS server");
       }
@@ -383,9 +700,12 @@ void setup() {
 }
 
 void loop() {
+  unsigned long loopStart = micros();
   Time::updateTime();
   curTime = Time::now(false);
   if(tofSensor.dataReady()){ curDistance = tofSensor.read(false); }
+  dataPoints.sync();
+  settings.poll();
   handleNet();
   switch(curMode){
     case(Mode::REGULAR):
@@ -398,5 +718,7 @@ void loop() {
       handleLight();
       break;
   }
+  uint32_t loopUs = micros() - loopStart;
+  if(loopUs > loopMaxUs){ loopMaxUs = loopUs; }
   delay(LOOP_DELAY);
 }
\ No newline at end of file
@@ -0,0 +1,27 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef BUFFER_PRINT_H
+#define BUFFER_PRINT_H
+#include <Arduino.h>
+//Print that writes into a fixed buffer, stops writing (and sets overflow) when it is full
+class BufferPrint : public Print{
+  public:
+    BufferPrint(char *buf, size_t size) : len(0), overflow(false), _buf(buf), _size(size){}
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *data, size_t n) override {
+      if(len + n > _size){
+        overflow = true;
+        return 0;
+      }
+      memcpy(_buf + len, data, n);
+      len += n;
+      return n;
+    }
+    size_t room() const { return _size - len; }
+    size_t len;
+    bool overflow;
+  private:
+    char *_buf;
+    size_t _size;
+};
+#endif //BUFFER_PRINT_H
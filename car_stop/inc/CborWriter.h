@@ -0,0 +1,118 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef CBOR_WRITER_H
+#define CBOR_WRITER_H
+#include <Arduino.h>
+#include <stdint.h>
+//Writes CBOR (RFC 8949) straight into a fixed size buffer and sends it to out whenever the buffer fills up
+//Maps and arrays are written with indefinite length so the item count doesn't have to be known up front
+class CborWriter{
+  public:
+    enum MajorType : uint8_t{
+      UINT = 0,
+      NEG_INT = 1,
+      BYTES = 2,
+      TEXT = 3,
+      ARRAY = 4,
+      MAP = 5,
+      TAG = 6,
+      SIMPLE = 7
+    };
+    static const uint8_t FALSE = 0xF4;
+    static const uint8_t TRUE = 0xF5;
+    static const uint8_t NULL_VAL = 0xF6;
+    static const uint8_t BREAK = 0xFF;
+    static const uint8_t INDEFINITE = 31; //Additional info for indefinite length
+    static const uint64_t TAG_IPV4 = 52; //RFC 9164
+    CborWriter(Print &out, uint8_t *buf, size_t size):
+      _out(out),
+      _buf(buf),
+      _size(size),
+      _len(0)
+    {}
+    ~CborWriter(){ flush(); }
+
+    void beginMap(){ _put((MAP << 5) | INDEFINITE); }
+    void beginArray(){ _put((ARRAY << 5) | INDEFINITE); }
+    //Ends the current map or array
+    void end(){ _put(BREAK); }
+
+    void key(const char *k, size_t len){ text(k, len); }
+    void key(const char *k){ text(k, strlen(k)); }
+
+    void value(uint64_t v){ _head(UINT, v); }
+    void value(int64_t v){
+      if(v < 0){ _head(NEG_INT, static_cast<uint64_t>(-(v + 1))); }
+      else{ _head(UINT, static_cast<uint64_t>(v)); }
+    }
+    void value(uint32_t v){ value(static_cast<uint64_t>(v)); }
+    void value(int32_t v){ value(static_cast<int64_t>(v)); }
+    void value(bool v){ _put(v ? TRUE : FALSE); }
+    void null(){ _put(NULL_VAL); }
+    void text(const char *str, size_t len){
+      _head(TEXT, len);
+      _write(reinterpret_cast<const uint8_t*>(str), len);
+    }
+    void bytes(const uint8_t *data, size_t len){
+      _head(BYTES, len);
+      _write(data, len);
+    }
+    void tag(uint64_t t){ _head(TAG, t); }
+
+    //Sends everything that is buffered
+    void flush(){
+      if(_len == 0){ return; }
+      _out.write(_buf, _len);
+      _len = 0;
+    }
+  private:
+    Print &_out;
+    uint8_t *_buf;
+    size_t _size;
+    size_t _len;
+
+    void _put(uint8_t b){
+      if(_len >= _size){ flush(); }
+      _buf[_len++] = b;
+    }
+    void _write(const uint8_t *data, size_t len){
+      while(len > 0){
+        if(_len >= _size){ flush(); }
+        size_t n = _size - _len < len ? _size - _len : len;
+        memcpy(_buf + _len, data, n);
+        _len += n;
+        data += n;
+        len -= n;
+      }
+    }
+    //Writes the initial byte (and argument) of an item using the shortest encoding
+    void _head(MajorType type, uint64_t arg){
+      uint8_t mt = type << 5;
+      uint8_t argBytes = 0;
+      if(arg < 24){
+        _put(mt | arg);
+        return;
+      }
+      else if(arg <= UINT8_MAX){
+        _put(mt | 24);
+        argBytes = 1;
+      }
+      else if(arg <= UINT16_MAX){
+        _put(mt | 25);
+        argBytes = 2;
+      }
+      else if(arg <= UINT32_MAX){
+        _put(mt | 26);
+        argBytes = 4;
+      }
+      else{
+        _put(mt | 27);
+        argBytes = 8;
+      }
+      //Big endian
+      while(argBytes-- > 0){
+        _put(static_cast<uint8_t>(arg >> (argBytes * 8)));
+      }
+    }
+};
+#endif //CBOR_WRITER_H
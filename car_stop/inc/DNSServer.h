@@ -4,9 +4,13 @@
 #define DNS_SERVER_H
 #include <cstdint>
 #include <AsyncUDP.h>
-//Simple DNS server that only replies to A record queries
-//Always in captive mode and replies with a fixed IP
-//Specific domains can be set to return NXDOMAIN
+#include "NameTable.h"
+#include "TopNames.h"
+#include "JsonWriter.h"
+//Simple DNS server that only answers A record queries
+//Always in captive mode and replies with a fixed IP, AAAA and HTTPS queries get an empty answer
+//Specific domains (or everything under one, *.domain) can be set to return NXDOMAIN or another IP
+//Keeps counts of what it was asked and how it answered, and answers a non-A query it just answered from a copy of the reply
 class DNSServer {
     public:
         enum OpCode : uint8_t{
@@ -31,9 +35,12 @@ class DNSServer {
             MX = 15, //Mail exchange
             TXT = 16, //Text
             AAAA = 28, //Address (IPv6)
+            OPT = 41, //EDNS options
+            SVCB = 64, //Service binding
+            HTTPS = 65, //Service binding for HTTPS
             ANY = 255
         };
-        enum Class : uint16_t{
+        enum class Class : uint16_t{ //Scoped, ANY would clash with Type's
             IN = 1,
             CS = 2,
             CH = 3,
@@ -63,7 +70,7 @@ class DNSServer {
             uint16_t addRRCnt; //Additional resource records
         };
         struct Question{
-            uint8_t *name;
+            const uint8_t *name;
             uint16_t type;
             uint16_t classCode;
         };
@@ -73,129 +80,371 @@ class DNSServer {
             uint16_t dataLength;
             uint8_t data[4]; //Answer
         };
-        const uint8_t MAX_NX_DOMAINS = 4;
+        struct Answer{
+            bool nx; //NXDOMAIN instead of ip
+            uint8_t ip[4];
+        };
+        //Written from AsyncUDP's task, each count is read whole
+        struct Stats{
+            uint32_t queries = 0; //Packets handled
+            uint32_t cached = 0; //Answered from the cache
+            uint32_t dropped = 0; //Not answered
+            uint32_t a = 0; //Questions by type
+            uint32_t aaaa = 0;
+            uint32_t https = 0;
+            uint32_t otherType = 0;
+            uint32_t noError = 0; //Replies by code
+            uint32_t nxDomain = 0;
+            uint32_t formErr = 0;
+            uint32_t notImp = 0;
+            uint32_t handlerTime = 0; //Total us spent on packets, replying included
+            uint32_t maxHandlerTime = 0; //Longest in us
+        };
+        static const uint16_t DOMAIN_SLOTS = 512; //Up to 256 domains
+        static const uint16_t DOMAIN_POOL_BYTES = 8192; //For their names, 32 bytes each for 256
         static const uint8_t DNS_HEADER_SIZE = 12;
         static const uint8_t POINTER_BYTE = 0xc0;
         static const uint8_t ANSWER_SIZE = 16;
-        DNSServer(IPAddress ip, uint16_t port = 53) : _port(port), _ip(ip) {
+        static const uint8_t OPT_SIZE = 11;
+        static const uint8_t MAX_LABEL_BYTES = 63;
+        static const uint16_t MAX_NAME_BYTES = 255;
+        static const uint16_t MAX_REPLY_BYTES = 512; //Largest UDP reply without EDNS
+        static const uint8_t TOP_NAMES = 8;
+        static const uint8_t TOP_NAME_BYTES = 64; //Kept to show per name
+        static const uint8_t CACHE_ENTRIES = 4;
+        static const uint8_t CACHE_QUERY_BYTES = 96; //Longer queries aren't cached
+        static const uint32_t CACHE_US = 2000000; //Long enough for a client's retries and the same query from its other apps
+        DNSServer(uint16_t port = 53) : _port(port) {}
+        //Domains are set before start(), replies are sent from AsyncUDP's task
+        //Returns false if domain isn't a valid name or there is no room left for it
+        bool addNXDomain(const String& domain){ return _addDomain(domain, {true, {0, 0, 0, 0}}); }
+        bool addDomain(const String& domain, const IPAddress &ip){ return _addDomain(domain, {false, {ip[0], ip[1], ip[2], ip[3]}}); }
+        void clearDomains(){
+            _domains.clear();
+            _clearCache();
+        }
+        //Replies to A queries with ip (the AP's, it isn't known until the AP is up)
+        bool start(const IPAddress &ip){
             for(uint8_t i = 0; i < 4; ++i){
-                _defaultResponse.data[i] = _ip[i];
+                _defaultResponse.data[i] = ip[i];
             }
-        }
-        void addNXDomain(const String& domain){
-            if(_nxIdx >= MAX_NX_DOMAINS){ return; }
-            _nxDomains[_nxIdx++] = _toName(domain);
-        }
-        bool start(){
-            if(!_udp.listen(_port)){ return false; }
+            _packAnswer();
+            _clearCache();
             _udp.onPacket([this](AsyncUDPPacket &packet){
                 this->_handlePacket(packet);
             });
-            return true;
+            return _udp.listen(_port);
         }
         void stop(){ _udp.close(); }
+        Stats& stats(){ return _stats; }
+        //Stats, with the questions by type, replies by code and top names broken out
+        void writeJSON(JsonWriter &json) const {
+            json.beginObject();
+            json.key("queries");
+            json.value(_stats.queries);
+            json.key("cached");
+            json.value(_stats.cached);
+            json.key("dropped");
+            json.value(_stats.dropped);
+            json.key("types");
+            json.beginObject();
+            json.key("A");
+            json.value(_stats.a);
+            json.key("AAAA");
+            json.value(_stats.aaaa);
+            json.key("HTTPS");
+            json.value(_stats.https);
+            json.key("other");
+            json.value(_stats.otherType);
+            json.endObject();
+            json.key("codes");
+            json.beginObject();
+            json.key("NOERROR");
+            json.value(_stats.noError);
+            json.key("NXDOMAIN");
+            json.value(_stats.nxDomain);
+            json.key("FORMERR");
+            json.value(_stats.formErr);
+            json.key("NOTIMP");
+            json.value(_stats.notImp);
+            json.endObject();
+            json.key("handlerUs");
+            json.value(_stats.handlerTime);
+            json.key("maxHandlerUs");
+            json.value(_stats.maxHandlerTime);
+            json.key("top");
+            _topNames.writeJSON(json);
+            json.endObject();
+        }
+        //Builds the reply to a query in the server's reply buffer, reply points to it
+        //Returns the reply's length, 0 if the query doesn't get one
+        //The reply is only good until the next call, AsyncUDP hands packets over one at a time
+        size_t respond(const uint8_t *query, size_t length, const uint8_t *&reply){ return respond(query, length, reply, micros()); }
+        //now is micros() when the query came in, for the cache
+        size_t respond(const uint8_t *query, size_t length, const uint8_t *&reply, uint32_t now){
+            reply = _replyBuf;
+            ++_stats.queries;
+            CachedReply *cached = _findCached(query, length, now);
+            if(cached != nullptr){
+                ++_stats.cached;
+                memcpy(_replyBuf, cached->reply, cached->replyLength);
+                memcpy(_replyBuf, query, 2); //Id
+                _count(cached->reply + DNS_HEADER_SIZE, cached->nameLength, cached->type, cached->rCode);
+                return cached->replyLength;
+            }
+            uint16_t type = 0;
+            uint16_t nameLength = 0;
+            size_t replyLength = _build(query, length, type, nameLength);
+            if(replyLength == 0){
+                ++_stats.dropped;
+                return 0;
+            }
+            uint8_t rCode = _replyBuf[3] & 0x0f;
+            _count(_replyBuf + DNS_HEADER_SIZE, nameLength, type, rCode);
+            if(nameLength > 0 && type != Type::A){ _cache(query, length, now, replyLength, type, rCode, nameLength); }
+            return replyLength;
+        }
     private:
+        struct CachedReply{
+            uint32_t time; //micros() it was cached at
+            uint8_t queryLength = 0; //Without the id, 0 if unused
+            uint8_t replyLength;
+            uint8_t nameLength;
+            uint8_t rCode;
+            uint16_t type;
+            uint8_t query[CACHE_QUERY_BYTES - 2];
+            uint8_t reply[CACHE_QUERY_BYTES + ANSWER_SIZE + OPT_SIZE]; //The question is never longer than in the query
+        };
+        Stats _stats;
+        TopNames<TOP_NAMES, TOP_NAME_BYTES> _topNames;
+        CachedReply _replyCache[CACHE_ENTRIES];
+        uint8_t _cacheNext = 0; //Entry the next reply goes in
+        //Builds the reply in _replyBuf, type and nameLength are set to the question's if it has one
+        size_t _build(const uint8_t *query, size_t length, uint16_t &type, uint16_t &nameLength){
+            if(length < DNS_HEADER_SIZE){ return 0; }
+
+            Header header;
+            memcpy(&header, query, DNS_HEADER_SIZE);
+            if(header.flags.qr == 1){ return 0; } //Not a query
+            if(header.flags.op != QUERY){ return _reply(header, 0, ResCode::NOTIMP); }
+            uint16_t qCnt = ntohs(header.qCnt);
+            if(qCnt == 0){ return _reply(header, 0, ResCode::FORMERR); }
+
+            //Only the first question is answered, it goes in the reply as is (uncompressed)
+            size_t pos;
+            nameLength = _readName(query, length, DNS_HEADER_SIZE, _replyBuf + DNS_HEADER_SIZE, pos);
+            if(nameLength == 0 || length - pos < 4){
+                nameLength = 0;
+                return _reply(header, 0, ResCode::FORMERR);
+            }
+            const uint8_t *name = _replyBuf + DNS_HEADER_SIZE;
+            memcpy(_replyBuf + DNS_HEADER_SIZE + nameLength, query + pos, 4); //Type + Class
+            type = _read16(query + pos);
+            uint16_t classCode = _read16(query + pos + 2);
+            bool edns = _hasOPT(query, length, pos + 4, qCnt - 1, header);
+            uint16_t questionLength = nameLength + 4;
+
+            if(classCode != static_cast<uint16_t>(Class::IN) && classCode != static_cast<uint16_t>(Class::ANY)){
+                return _reply(header, questionLength, ResCode::NXDOMAIN, nullptr, edns);
+            }
+            const Answer *domain = _domains.find(name, nameLength);
+            if(domain != nullptr && domain->nx){ return _reply(header, questionLength, ResCode::NXDOMAIN, nullptr, edns); }
+            const uint8_t *ip = domain != nullptr ? domain->ip : _defaultResponse.data;
+            switch(type){
+                case Type::A:
+                case Type::ANY:
+                    return _reply(header, questionLength, ResCode::NOERROR, ip, edns);
+                case Type::AAAA:
+                case Type::HTTPS: //Empty answer, the client goes on with the A record instead of waiting on or retrying these
+                    return _reply(header, questionLength, ResCode::NOERROR, nullptr, edns);
+                default:
+                    return _reply(header, questionLength, ResCode::NXDOMAIN, nullptr, edns);
+            }
+        }
         AsyncUDP _udp;
         uint16_t _port;
-        IPAddress _ip;
-        String _nxDomains[MAX_NX_DOMAINS];
+        NameTable<DOMAIN_SLOTS, DOMAIN_POOL_BYTES, Answer> _domains;
         Record _defaultResponse = {
             .question = {
                 .name = nullptr,
                 .type = htons(Type::A),
-                .classCode = htons(Class::IN)
+                .classCode = htons(static_cast<uint16_t>(Class::IN))
             },
             .ttl = htonl(7200),
             .dataLength = htons(4),
             .data = {0, 0, 0, 0}
         };
-        uint8_t _nxIdx = 0;
-        void _reply(AsyncUDPPacket &packet, const uint8_t nameLength, Header &header, ResCode resCode = ResCode::NOERROR){
-            header.qCnt = htons(1);
-            header.aCnt = resCode == ResCode::NOERROR ? htons(1) : 0;
+        uint8_t _answer[ANSWER_SIZE]; //_defaultResponse as it goes on the wire
+        uint8_t _replyBuf[MAX_REPLY_BYTES];
+        void _packAnswer(){
+            uint8_t* idx = _answer;
+            //Name pointer
+            *idx = POINTER_BYTE;
+            ++idx;
+            *idx = DNS_HEADER_SIZE; //Pointer offset
+            ++idx;
+            memcpy(idx, &_defaultResponse.question.type, 2);
+            idx += 2;
+            memcpy(idx, &_defaultResponse.question.classCode, 2);
+            idx += 2;
+            memcpy(idx, &_defaultResponse.ttl, 4);
+            idx += 4;
+            memcpy(idx, &_defaultResponse.dataLength, 2);
+            idx += 2;
+            memcpy(idx, _defaultResponse.data, 4);
+        }
+        //Finishes the reply in _replyBuf, the question (if questionLength isn't 0) is already in it
+        //ip adds an A record with it, opt an OPT record (the query had one)
+        size_t _reply(Header &header, uint16_t questionLength, ResCode resCode, const uint8_t *ip = nullptr, bool opt = false){
+            header.qCnt = questionLength > 0 ? htons(1) : 0;
+            header.aCnt = ip != nullptr ? htons(1) : 0;
+            header.authRRCnt = 0;
+            header.addRRCnt = opt ? htons(1) : 0;
             header.flags.qr = 1; //Response
             header.flags.aa = 1; //Authoritative answer
+            header.flags.tc = 0;
             header.flags.ra = 1; //Recursion available
             header.flags.rCode = resCode;
-            uint8_t questionLength = nameLength + 4; //Name + Type + Class
-            uint16_t resLength = DNS_HEADER_SIZE + questionLength + (resCode == ResCode::NOERROR ? ANSWER_SIZE : 0); //Header + Question + Answer(if any)
-            uint8_t *response = new uint8_t[resLength]; 
-            //Header
-            memcpy(response, &header, DNS_HEADER_SIZE);
-            uint8_t* idx = response + DNS_HEADER_SIZE;
-            //Question
-            memcpy(idx, packet.data()+DNS_HEADER_SIZE, questionLength);
-            idx += questionLength;
-            //Answer
-            if(resCode == ResCode::NOERROR){
-                //Name pointer
-                *idx = POINTER_BYTE;
-                ++idx;
-                *idx = DNS_HEADER_SIZE; //Pointer offset
-                ++idx;
-                memcpy(idx, &_defaultResponse.question.type, 2);
-                idx += 2;
-                memcpy(idx, &_defaultResponse.question.classCode, 2);
-                idx += 2;
-                memcpy(idx, &_defaultResponse.ttl, 4);
-                idx += 4;
-                memcpy(idx, &_defaultResponse.dataLength, 2);
-                idx += 2;
-                memcpy(idx, _defaultResponse.data, 4);
-            }
-            packet.reply(response, resLength);
-            delete[] response;
+            memcpy(_replyBuf, &header, DNS_HEADER_SIZE);
+            uint8_t* idx = _replyBuf + DNS_HEADER_SIZE + questionLength;
+            if(ip != nullptr){
+                memcpy(idx, _answer, ANSWER_SIZE - 4);
+                memcpy(idx + ANSWER_SIZE - 4, ip, 4);
+                idx += ANSWER_SIZE;
+            }
+            if(opt){ //Root name, our payload size, no extended code or options
+                memset(idx, 0, OPT_SIZE);
+                idx[2] = Type::OPT;
+                idx[3] = MAX_REPLY_BYTES >> 8;
+                idx[4] = MAX_REPLY_BYTES & 0xff;
+                idx += OPT_SIZE;
+            }
+            return idx - _replyBuf;
         }
         void _handlePacket(AsyncUDPPacket &packet){
-            if(packet.length() < DNS_HEADER_SIZE){ return; } 
-
-            Header header;
-            memcpy(&header, packet.data(), DNS_HEADER_SIZE);
-            header.qCnt = ntohs(header.qCnt);
-            if(header.flags.qr == 1 || header.qCnt != 1 || header.flags.op != QUERY){ return; }
-
-            bool nx = false; //Whether to reply with NXDOMAIN
-            int nameLength = 0;
-            uint8_t* nameEnd = nullptr;
-            Question question;
-            if(memchr(packet.data()+DNS_HEADER_SIZE, POINTER_BYTE, packet.length()-DNS_HEADER_SIZE) != nullptr){ //Compressed
-                nx = true;
-                nameEnd = packet.data()+DNS_HEADER_SIZE+2;
-                nameLength = 2; //Pointer length
-            }
-            else{ //Not compressed
-                nameEnd = (uint8_t*)memchr(packet.data()+DNS_HEADER_SIZE, '\0', packet.length()-DNS_HEADER_SIZE);
-                if(nameEnd == nullptr){ //No null terminator
-                    nx = true;
-                    nameLength = packet.length() - DNS_HEADER_SIZE;
-                }
+            uint32_t start = micros();
+            const uint8_t *reply;
+            size_t length = respond(packet.data(), packet.length(), reply, start);
+            if(length > 0){ packet.reply(reply, length); }
+            uint32_t time = micros() - start;
+            _stats.handlerTime += time;
+            if(time > _stats.maxHandlerTime){ _stats.maxHandlerTime = time; }
+        }
+        void _count(const uint8_t *name, uint16_t nameLength, uint16_t type, uint8_t rCode){
+            switch(rCode){
+                case ResCode::NOERROR: ++_stats.noError; break;
+                case ResCode::NXDOMAIN: ++_stats.nxDomain; break;
+                case ResCode::FORMERR: ++_stats.formErr; break;
+                case ResCode::NOTIMP: ++_stats.notImp; break;
             }
-            //Ensure the rest of the question exists
-            if((packet.data() + packet.length()) - nameEnd < 4){ 
-                return; //Cant reply because we dont have full question
+            if(nameLength == 0){ return; } //No question
+            switch(type){
+                case Type::A: ++_stats.a; break;
+                case Type::AAAA: ++_stats.aaaa; break;
+                case Type::HTTPS: ++_stats.https; break;
+                default: ++_stats.otherType; break;
             }
-            if(!nx){ //No errors so far
-                question.name = packet.data()+DNS_HEADER_SIZE; //Start of null terminated string
-
-                memcpy(&question.type, nameEnd+1, 2);
-                question.type = ntohs(question.type);
-
-                memcpy(&question.classCode, nameEnd+3, 2);
-                question.classCode = ntohs(question.classCode);
-
-                if((question.type != Type::A && question.type != Type::ANY) || (question.classCode != Class::IN && question.classCode != Class::ANY)){ nx = true; }
-                else{
-                    nameLength = nameEnd - (packet.data() + DNS_HEADER_SIZE) + 1; //+1 to include nameEnd in count
-                    for(uint8_t i = 0; i < _nxIdx; ++i){
-                        if(_nxDomains[i].length() != nameLength){ continue; }
-                        if(memcmp(packet.data()+DNS_HEADER_SIZE, _nxDomains[i].c_str(), nameLength) == 0){
-                            nx = true;
-                            break;
-                        }
-                    }
+            _topNames.add(name, nameLength);
+        }
+        //Cached reply to the same query (id aside) from the last CACHE_US, nullptr if there isn't one
+        //Only non-A replies are cached, an A question (most of them) doesn't look
+        CachedReply* _findCached(const uint8_t *query, size_t length, uint32_t now){
+            size_t pos = DNS_HEADER_SIZE;
+            if(length > CACHE_QUERY_BYTES || !_skipName(query, length, pos) || length - pos < 2 || _read16(query + pos) == Type::A){ return nullptr; }
+            for(uint8_t i = 0; i < CACHE_ENTRIES; ++i){
+                CachedReply &c = _replyCache[i];
+                if(c.queryLength == length - 2 && now - c.time < CACHE_US && memcmp(c.query, query + 2, length - 2) == 0){ return &c; }
+            }
+            return nullptr;
+        }
+        //Keeps the reply in _replyBuf to query, in place of the oldest one
+        void _cache(const uint8_t *query, size_t length, uint32_t now, size_t replyLength, uint16_t type, uint8_t rCode, uint16_t nameLength){
+            if(length > CACHE_QUERY_BYTES || replyLength > sizeof(CachedReply::reply)){ return; }
+            CachedReply &c = _replyCache[_cacheNext];
+            _cacheNext = (_cacheNext + 1) % CACHE_ENTRIES;
+            c.time = now;
+            c.queryLength = length - 2;
+            c.replyLength = replyLength;
+            c.nameLength = nameLength;
+            c.rCode = rCode;
+            c.type = type;
+            memcpy(c.query, query + 2, length - 2);
+            memcpy(c.reply, _replyBuf, replyLength);
+        }
+        void _clearCache(){
+            for(uint8_t i = 0; i < CACHE_ENTRIES; ++i){ _replyCache[i].queryLength = 0; }
+        }
+        static uint16_t _read16(const uint8_t *data){ return (data[0] << 8) | data[1]; }
+        //Copies the name at offset in packet to out (MAX_NAME_BYTES) uncompressed, following pointers
+        //Pointers can only go back from where the last one went, so a loop ends
+        //end is set to where the name ends in the packet (after the first pointer if there is one)
+        //Returns the name's length with the root label, 0 if it is malformed
+        static uint16_t _readName(const uint8_t *packet, size_t length, size_t offset, uint8_t *out, size_t &end){
+            uint16_t outLength = 0;
+            size_t pos = offset;
+            size_t limit = offset; //Pointers have to go before this
+            bool jumped = false;
+            while(pos < length){
+                uint8_t labelLength = packet[pos];
+                if((labelLength & POINTER_BYTE) == POINTER_BYTE){
+                    if(length - pos < 2){ return 0; }
+                    size_t target = ((labelLength & ~POINTER_BYTE) << 8) | packet[pos + 1];
+                    if(target < DNS_HEADER_SIZE || target >= limit){ return 0; }
+                    if(!jumped){ end = pos + 2; }
+                    jumped = true;
+                    pos = limit = target;
+                    continue;
+                }
+                if(labelLength > MAX_LABEL_BYTES){ return 0; } //0x40 and 0x80 label types aren't used
+                if(length - pos < labelLength + 1u || outLength + labelLength + 1 > MAX_NAME_BYTES){ return 0; }
+                memcpy(out + outLength, packet + pos, labelLength + 1);
+                outLength += labelLength + 1;
+                pos += labelLength + 1;
+                if(labelLength == 0){
+                    if(!jumped){ end = pos; }
+                    return outLength;
                 }
             }
-            _reply(packet, nameLength, header, nx ? ResCode::NXDOMAIN : ResCode::NOERROR);
+            return 0;
+        }
+        //Steps pos over the name at it without following pointers, returns false if it runs off the packet
+        static bool _skipName(const uint8_t *packet, size_t length, size_t &pos){
+            while(pos < length){
+                uint8_t labelLength = packet[pos];
+                if((labelLength & POINTER_BYTE) == POINTER_BYTE){
+                    pos += 2;
+                    return pos <= length;
+                }
+                if(labelLength > MAX_LABEL_BYTES){ return false; }
+                pos += labelLength + 1;
+                if(labelLength == 0){ return true; }
+            }
+            return false;
+        }
+        //Whether the records after the first question (at pos) have an OPT one (EDNS)
+        //A malformed rest of the packet counts as not having one
+        static bool _hasOPT(const uint8_t *packet, size_t length, size_t pos, uint16_t questions, const Header &header){
+            for(uint16_t i = 0; i < questions; ++i){
+                if(!_skipName(packet, length, pos) || length - pos < 4){ return false; }
+                pos += 4;
+            }
+            uint32_t records = static_cast<uint32_t>(ntohs(header.aCnt)) + ntohs(header.authRRCnt) + ntohs(header.addRRCnt);
+            for(uint32_t i = 0; i < records; ++i){
+                if(!_skipName(packet, length, pos) || length - pos < 10){ return false; }
+                if(_read16(packet + pos) == Type::OPT){ return true; }
+                pos += 10;
+                uint16_t dataLength = _read16(packet + pos - 2);
+                if(length - pos < dataLength){ return false; }
+                pos += dataLength;
+            }
+            return false;
+        }
+        bool _addDomain(String domain, const Answer &answer){
+            bool wildcard = domain.startsWith("*.");
+            if(wildcard){ domain = domain.substring(2); }
+            if(domain.endsWith(".")){ domain = domain.substring(0, domain.length() - 1); }
+            String name = _toName(domain);
+            return _domains.add(reinterpret_cast<const uint8_t*>(name.c_str()), name.length(), wildcard, answer);
         }
         String _toName(const String& name){
             String out{};
@@ -215,6 +464,7 @@ class DNSServer {
                     ++cnt;
                 }
             }
+            if(cnt > 63){ return String(); }//Over length
             out += (char)cnt;
             out += name.substring(dotIdx+1, i);
             out += '\0'; //Null terminator
@@ -4,12 +4,20 @@
 #define DATA_POINT_H
 #include <Arduino.h>
 #include <stdint.h>
+#include <errno.h>
+#include <type_traits>
+#include <limits>
 #include "Time.h"
 #include "Util.h"
-//Data point used for viewing and modifying variabled
-//Stores a void pointer to the data and its type
+#include "JsonWriter.h"
+#include "CborWriter.h"
+#include "History.h"
+//Data point used for viewing and modifying variables
+//This is the untyped interface the manager and web pages work with,
+//TypedDataPoint<T> holds the pointer to the variable and does the conversions for its type
 struct DataPoint{
   using status_t = uint8_t;
+  using seq_t = uint32_t;
   enum Type{
     //Castable to ints
     UINT8 = 0,//Unsigned
@@ -17,12 +25,17 @@ struct DataPoint{
     UINT64,
     TIME,
     BOOL,
+    UINT16,
     INT8 = 50,//Signed
     INT,
     VOID = 100,//Not castable to ints
     STR,
     IP
   };
+  //Max length of a value as text (longest is a string value, ie wifi password)
+  static const size_t MAX_STR_LEN = 64;
+  //Max length of a value in binary form (see toBytes)
+  static const size_t MAX_BYTES = MAX_STR_LEN;
   //Used for filtering data points based on their attributes
   struct Filter{
     enum class Type{
@@ -31,21 +44,18 @@ struct DataPoint{
       SETTABLE //Filter based on whether it's settable
     } type;
     static const uint8_t TYPE_COUNT {2};
+    static const uint8_t MAX_FILTERS {4}; //Most filters a single request can use
 
     uint8_t value; //Value to filter on (TYPE = type value, SETTABLE = whether settable)
     bool inverse; //Whether to invert the filter
 
     Filter(Type t, uint8_t val, bool invert = 0) : type(t), value(val), inverse(invert){}
     Filter() : type(Type::NONE), value(0), inverse(0){}
-    Filter operator=(const Filter &rhs){
-      type = rhs.type;
-      value = rhs.value;
-    }
 
     //Parses a string a returns the filter it represents
     //Filters are the following
     //  s[v] - Settable, v should be either 0 (no settable), or 1 (settable)
-    //  t[v] - Type, v should be a valid type value, see DataPoint::Type enum above for valid values 
+    //  t[v] - Type, v should be a valid type value, see DataPoint::Type enum above for valid values
     //  filters can have a '!' before v to invert the filter
     //If the string is bad then the type will be set to NONE
     static Filter parseString(const String &str){
@@ -73,10 +83,11 @@ struct DataPoint{
               case DataPoint::Type::STR:
               case DataPoint::Type::TIME:
               case DataPoint::Type::UINT:
+              case DataPoint::Type::UINT16:
               case DataPoint::Type::UINT64:
               case DataPoint::Type::UINT8:
               case DataPoint::Type::VOID:
-              case DataPoint::Type::IP: 
+              case DataPoint::Type::IP:
                 //Valid type
                 filter.type = Type::TYPE;
                 filter.value = v;
@@ -114,298 +125,424 @@ struct DataPoint{
     OK = 2,
     BAD = 4
   };
-  using data_t = void *;
-  //Used when no set function is set
-  static status_t dummyFn(data_t, Type){
-    return OK;
-  }
-  String name; //Name of the datapoint
+  const char *name; //Name of the datapoint
+  const uint8_t nameLen;
   const Type type;
-  data_t data;
   const bool settable; //Whether the data point is settable
+  const bool persistent; //Whether the value is saved to flash and restored at boot (see SettingStore)
+  seq_t changeSeq; //Sequence number of the last change (0 if it hasn't changed since boot)
+  HistoryBase *history; //Past values of the data point, nullptr if it doesn't keep any
   bool isInteger() const {
     return type < Type::VOID;
   }
-  //Set function (not used directly)
-  //Returns whether the var should be changed
-  status_t (&set)(data_t, Type); 
-  //Used to set the value
-  //Returns whether the value was set
-  status_t setVal(data_t d){ 
-    if(!settable || d == nullptr || data == nullptr){
-      return BAD;
-    }
-    status_t r = set(d, type);
-    if(r == OK){
-      switch(type){
-        case BOOL:
-        case UINT8:
-          *static_cast<uint8_t*>(data) = *static_cast<uint8_t*>(d);
-          break;
-        case INT8:
-          *static_cast<int8_t*>(data) = *static_cast<int8_t*>(d);
-          break;
-        case INT:
-          *static_cast<int32_t*>(data) = *static_cast<int32_t*>(d);
-          break;
-        case UINT:
-          *static_cast<uint32_t*>(data) = *static_cast<uint32_t*>(d);
-        case UINT64:
-          *static_cast<uint64_t*>(data) = *static_cast<uint64_t*>(d);
-          break;
-        case TIME:
-          *static_cast<Time::Time_t*>(data) = *static_cast<Time::Time_t*>(d);
-          break;
-        case VOID:
-          data = d;
-          break;
-        case STR:
-          *static_cast<String*>(data) = *static_cast<String*>(d);
-          break;
-        case IP:
-          *static_cast<IPAddress*>(data) = *static_cast<IPAddress*>(d);
-          break;
-      };
-    }
-    return r;
-  }
-  //Returns whether the datapoint is positive
-  static bool isPositive(DataPoint::data_t d, DataPoint::Type t){
-    if(t < DataPoint::Type::INT8){//Unsigned type
-      return true;
-    }
-    else if(t < DataPoint::Type::VOID){//Signed type
-      if(t == DataPoint::Type::INT8){
-        return *static_cast<int8_t*>(d) >= 0;
-      }
-      else if(t == DataPoint::Type::INT){
-        return *static_cast<int32_t*>(d) >= 0;
-      }
-    }
-    else if(t == DataPoint::Type::IP){
-      return true;
-    }
-    return false;
-  }
 
-  static bool isPosNonZero(DataPoint::data_t d, DataPoint::Type t){
-    if(t < DataPoint::Type::VOID && t >= DataPoint::Type::INT8){ //Signed type
-      if(t == DataPoint::Type::INT8){
-        return *static_cast<int8_t*>(d) > 0;
-      }
-      else if(t == DataPoint::Type::INT){
-        return *static_cast<int32_t*>(d) > 0;
-      }
-    }
-    return isPositive(d, t);
-  }
+  //Sequence number of the latest change to any data point
+  static seq_t curSeq(){ return _seq; }
 
-  //Returns whether the string is an IPv4 address
-  static bool isIPAddress(const String &s){
-    /*if(s.length() > 15){ //Max length of ipv4
-      return 0;
-    }
-    int idx = 0, endIdx = 0;
-    uint8_t octetCount = 0;
-    do{
-      if(octetCount > 4){
-        return 0;
-      }
-      endIdx = s.indexOf('.', idx);
-      String octet = s.substring(idx, endIdx);
-      if(!isInt(octet, 0)){
-        return 0;
-      }
-      int64_t val = toInt(octet);
-      if(val > 255){
-        return 0;
-      }
-      idx = endIdx + 1;
-      ++octetCount;
-    }while(idx > 0);
-    if(octetCount != 4){
-      return 0;
-    }
-    return 1;*/
-    IPAddress ip {};
-    if(!ip.fromString(s)){
-      return false;
-    }
-    return ip.type() == IPType::IPv4;
-  }
+  //Marks the data point as changed
+  void stamp(){ changeSeq = ++_seq; }
+
+  //Whether the data point changed after seq
+  bool changedSince(seq_t seq) const { return changeSeq > seq; }
+
+  //Checks whether the variable was changed without going through the data point and stamps it if it was
+  //Returns whether it changed
+  virtual bool sync(){ return false; }
 
   //Returns whether the string contains valid data for the data point type
-  static bool validateData(const String &val, Type type){
-    switch(type){
-      case Type::BOOL:
-        if(val != "0" || val != "1"){
-          return false;
-        }
-        return 1;
-      case Type::UINT8:{
-        if(!isInt(val, 0)){
-          return false;
-        }
-        int64_t v = toInt(val);
-        return v >= 0 && v <= UINT8_MAX;
-      }
-      case Type::INT8:{
-        if(!isInt(val)){
-          return false;
-        }
-        int64_t v = toInt(val);
-        return v >= INT8_MIN && v <= INT8_MAX;
-      }
-      case Type::INT:{
-        if(!isInt(val, 0)){
-          return false;
-        }
-        int64_t v = toInt(val);
-        return v >= INT32_MIN && v <= INT32_MAX;
-      }
-      case Type::TIME:
-        if(isInt(val, 0)){
-          return 1;
-        }
-        return Time::isTime(val);
-      case Type::UINT:
-      case Type::UINT64:
-        return isInt(val, 0);
-      case Type::IP:
-        return isIPAddress(val);
-      case Type::STR:
-        return 1;
-      case Type::VOID:
-        return 0;
-    };
-  }
+  virtual bool validateData(const String &val) const { return false; }
 
   //Sets the value from a string containg the value
   //Verifies data
   //Returns whether the value was set
-  status_t setValueStr(const String &str){
-    if(!validateData(str, type)){
-      return BAD;
-    }
-    if(type == Type::TIME){
-      Time t {Time::toTime(str)};
-      return setVal(&t.raw);
-    }
-    else if(type < Type::VOID){ //Integer
-      int64_t val = toInt(str);
-      return setVal(&val);
-    }
-    else if(type == Type::STR){
-      String val {str};
-      replaceURIEncodedChars(val);
-      return setVal(&val);
-    }
-    else if(type == Type::IP){
-      IPAddress ip {};
-      ip.fromString(str);
-      return setVal(&ip);
-    }
-    return BAD;
+  virtual status_t setValueStr(const String &str){ return BAD; }
+
+  //Writes the value as text to buf (always null terminated if size > 0)
+  //If formatTime is true then times will be formatted for human radability (ie 5:00 instead of 300)
+  //Returns the length of the full value, which can be more than size (output is cut off then)
+  virtual size_t toChars(char *buf, size_t size, bool formatTime = false) const {
+    return snprintf(buf, size, "null");
   }
 
+  //Writes the value as a single CBOR item, encoded from the value itself (no text conversion)
+  virtual void writeCBORValue(CborWriter &cbor) const {
+    cbor.null();
+  }
+
+  //Writes the value in binary form to buf, ie for storing it (see DataCodec pack())
+  //Returns the number of bytes written, 0 if it didn't fit or there is no value
+  virtual size_t toBytes(uint8_t *buf, size_t size) const { return 0; }
+
+  //Sets the value from bytes written by toBytes, goes through the same checks as setValueStr
+  virtual status_t setValueBytes(const uint8_t *buf, size_t len){ return BAD; }
+
   //Converts data point value to a string
   String toString(bool formatTime = 0) const {
-    if(data == nullptr){
-      return "null";
-    }
-    else{
-      String out {};
-      switch(type){
-        case BOOL:
-        case UINT8://Without cast to int it would be treated as a char
-          out = static_cast<int>(*static_cast<uint8_t*>(data));
-          break;
-        case INT8:
-          out = static_cast<int>(*static_cast<int8_t*>(data));
-          break;
-        case INT:
-          out = *static_cast<int32_t*>(data);
-          break;
-        case UINT:
-          out = *static_cast<uint32_t*>(data);
-          break;
-        case UINT64:
-          out = *static_cast<uint64_t*>(data);
-          break;
-        case TIME:
-          if(formatTime){
-            return Time::toString(*static_cast<Time::Time_t*>(data));
-          }
-          else{
-            out = *static_cast<Time::Time_t*>(data);
-          }
-          break;
-        case VOID:
-          out = "null";
-          break;
-        case STR:
-          return *static_cast<String*>(data);
-        case IP:
-          return static_cast<IPAddress*>(data)->toString();
-      };
-      return out;
-    }
+    char buf[MAX_STR_LEN + 1];
+    toChars(buf, sizeof(buf), formatTime);
+    return String(buf);
   }
 
-  /*Converts to a JSON object
+  /*Writes the data point as a member of the JSON object being written
     If formatTime is true then times will be formatted for human radability (ie 5:00 instead of 300)
-    Has the keys
-      - dp: data point name
+    The key is the data point name and the value is an object with the keys
       - val: value of data point
       - m: whether the data point is modifiable
       - t: type of data point (represented as an int)
   */
-  String toJSON(bool formatTime = false) const {
-    String out {};
-    out.reserve(50);
-    out += '\"';
-    out += name;
-    out += "\":{\n";
-    out += "\"val\":";
-    out += '"'; 
-    out += toString(formatTime);
-    out += '"'; 
-    out += ",\n";
-    out += "\"m\":";
-    out += settable;
-    out += ",\n";
-    out += "\"t\":";
-    out += type;
-    out += "\n}";
-    return out;
+  void writeJSON(JsonWriter &json, bool formatTime = false) const {
+    char val[MAX_STR_LEN + 1];
+    size_t len = toChars(val, sizeof(val), formatTime);
+    json.key(name, nameLen);
+    json.beginObject();
+    json.key("val");
+    json.value(val, len < sizeof(val) ? len : sizeof(val) - 1);
+    json.key("m");
+    json.raw(settable ? "1" : "0", 1);
+    json.key("t");
+    json.value(static_cast<uint32_t>(type));
+    json.endObject();
+  }
+
+  //Same as writeJSON but in CBOR, the value is encoded natively (see writeCBORValue)
+  void writeCBOR(CborWriter &cbor) const {
+    cbor.key(name, nameLen);
+    cbor.beginMap();
+    cbor.key("val");
+    writeCBORValue(cbor);
+    cbor.key("m");
+    cbor.value(settable);
+    cbor.key("t");
+    cbor.value(static_cast<uint32_t>(type));
+    cbor.end();
+  }
+
+  //Returns whether this data point matches every filter in filters
+  bool matchesFilters(const Filter *filters, uint8_t count) const {
+    for(uint8_t i = 0; i < count; ++i){
+      if(!matchesFilter(filters[i])){ return false; }
+    }
+    return true;
   }
 
   //Returns whether this data point matches the filter
   bool matchesFilter(const Filter &filter) const {
     switch(filter.type){
       case Filter::Type::TYPE:
-        if(filter.inverse){
-          return filter.value != type;
-        }
-        return filter.value == type;
+        return (filter.value == type) != filter.inverse;
       case Filter::Type::SETTABLE:
-        if(filter.inverse){
-          return static_cast<bool>(data) != settable;
-        }
-        return static_cast<bool>(data) == settable;
+        return (static_cast<bool>(filter.value) == settable) != filter.inverse;
       case Filter::Type::NONE:
         return 0;
     };
+    return 0;
+  }
+
+  bool nameEquals(const char *str, size_t len) const {
+    return nameLen == len && memcmp(name, str, len) == 0;
   }
 
   bool operator==(const DataPoint &rhs) const {
-    return name == rhs.name;
+    return nameEquals(rhs.name, rhs.nameLen);
   }
 
-  DataPoint(const char *n, data_t d, Type t, bool settable = false, status_t (&s)(data_t, Type) = dummyFn) : name(n), data(d), type(t), settable(settable), set(s){}
-  //Const constructor (will be unmodifiable no matter what)
-  DataPoint(const char *n, const void *d, Type t) : name(n), data(const_cast<void*>(d)), type(t), settable(0), set(dummyFn){}
+  DataPoint(const char *n, Type t, bool settable = false, bool persistent = false) : name(n), nameLen(strlen(n)), type(t), settable(settable), persistent(persistent), changeSeq(0), history(nullptr){}
   static const DataPoint NULL_DATAPOINT;
+  private:
+    static seq_t _seq;
+};
+const DataPoint DataPoint::NULL_DATAPOINT {"NULL", DataPoint::Type::VOID, false};
+DataPoint::seq_t DataPoint::_seq {0};
+
+//Conversions between a type and its text representation
+//Each supported type has a specialization with
+//  TYPE - the DataPoint::Type it's reported as
+//  validate() - whether a string holds a valid value
+//  parse() - validates and converts a string, returns whether it was valid
+//  format() - writes the value to a buffer, same return as DataPoint::toChars()
+//  encode() - writes the value as a CBOR item
+//  pack() - writes the value in binary form (little endian), returns the length or 0 if it didn't fit
+//  unpack() - reads a value written by pack(), returns whether it was valid
+template<typename T, typename Enable = void>
+struct DataCodec;
+
+//Any integer type
+template<typename T, DataPoint::Type TYPE_>
+struct IntCodec{
+  static const DataPoint::Type TYPE = TYPE_;
+  static bool validate(const String &val){
+    if(!isInt(val, std::numeric_limits<T>::is_signed)){ return false; }
+    //Long numbers could wrap around during conversion
+    if(val.length() > std::numeric_limits<T>::digits10 + 2){ return false; }
+    if(std::numeric_limits<T>::is_signed){
+      int64_t v = toInt(val);
+      return v >= static_cast<int64_t>(std::numeric_limits<T>::min()) && v <= static_cast<int64_t>(std::numeric_limits<T>::max());
+    }
+    errno = 0;
+    unsigned long long v = strtoull(val.c_str(), nullptr, 10);
+    return errno == 0 && v <= static_cast<unsigned long long>(std::numeric_limits<T>::max());
+  }
+  static bool parse(const String &val, T &out){
+    if(!validate(val)){ return false; }
+    if(std::numeric_limits<T>::is_signed){ out = static_cast<T>(toInt(val)); }
+    else{ out = static_cast<T>(strtoull(val.c_str(), nullptr, 10)); }
+    return true;
+  }
+  static size_t format(const T &val, char *buf, size_t size, bool){
+    if(std::numeric_limits<T>::is_signed){
+      return snprintf(buf, size, "%lld", static_cast<long long>(val));
+    }
+    return snprintf(buf, size, "%llu", static_cast<unsigned long long>(val));
+  }
+  static void encode(const T &val, CborWriter &cbor){
+    if(std::numeric_limits<T>::is_signed){ cbor.value(static_cast<int64_t>(val)); }
+    else{ cbor.value(static_cast<uint64_t>(val)); }
+  }
+  static size_t pack(const T &val, uint8_t *buf, size_t size){
+    if(size < sizeof(T)){ return 0; }
+    for(size_t i = 0; i < sizeof(T); ++i){ buf[i] = static_cast<uint8_t>(static_cast<uint64_t>(val) >> (i * 8)); }
+    return sizeof(T);
+  }
+  static bool unpack(const uint8_t *buf, size_t len, T &out){
+    if(len != sizeof(T)){ return false; }
+    uint64_t v = 0;
+    for(size_t i = 0; i < sizeof(T); ++i){ v |= static_cast<uint64_t>(buf[i]) << (i * 8); }
+    out = static_cast<T>(v);
+    return true;
+  }
+};
+
+template<> struct DataCodec<uint8_t> : IntCodec<uint8_t, DataPoint::UINT8>{};
+template<> struct DataCodec<uint16_t> : IntCodec<uint16_t, DataPoint::UINT16>{};
+template<> struct DataCodec<uint32_t> : IntCodec<uint32_t, DataPoint::UINT>{};
+template<> struct DataCodec<uint64_t> : IntCodec<uint64_t, DataPoint::UINT64>{};
+template<> struct DataCodec<int8_t> : IntCodec<int8_t, DataPoint::INT8>{};
+template<> struct DataCodec<int32_t> : IntCodec<int32_t, DataPoint::INT>{};
+
+//Enums are handled as their underlying integer
+template<typename T>
+struct DataCodec<T, typename std::enable_if<std::is_enum<T>::value>::type>{
+  using Underlying = typename std::underlying_type<T>::type;
+  static const DataPoint::Type TYPE = DataCodec<Underlying>::TYPE;
+  static bool validate(const String &val){ return DataCodec<Underlying>::validate(val); }
+  static bool parse(const String &val, T &out){
+    Underlying v;
+    if(!DataCodec<Underlying>::parse(val, v)){ return false; }
+    out = static_cast<T>(v);
+    return true;
+  }
+  static size_t format(const T &val, char *buf, size_t size, bool formatTime){
+    return DataCodec<Underlying>::format(static_cast<Underlying>(val), buf, size, formatTime);
+  }
+  static void encode(const T &val, CborWriter &cbor){
+    DataCodec<Underlying>::encode(static_cast<Underlying>(val), cbor);
+  }
+  static size_t pack(const T &val, uint8_t *buf, size_t size){
+    return DataCodec<Underlying>::pack(static_cast<Underlying>(val), buf, size);
+  }
+  static bool unpack(const uint8_t *buf, size_t len, T &out){
+    Underlying v;
+    if(!DataCodec<Underlying>::unpack(buf, len, v)){ return false; }
+    out = static_cast<T>(v);
+    return true;
+  }
+};
+
+template<>
+struct DataCodec<bool>{
+  static const DataPoint::Type TYPE = DataPoint::BOOL;
+  static bool validate(const String &val){ return val == "0" || val == "1"; }
+  static bool parse(const String &val, bool &out){
+    if(!validate(val)){ return false; }
+    out = val == "1";
+    return true;
+  }
+  static size_t format(const bool &val, char *buf, size_t size, bool){
+    return snprintf(buf, size, "%d", val ? 1 : 0);
+  }
+  static void encode(const bool &val, CborWriter &cbor){
+    cbor.value(val);
+  }
+  static size_t pack(const bool &val, uint8_t *buf, size_t size){
+    if(size < 1){ return 0; }
+    buf[0] = val;
+    return 1;
+  }
+  static bool unpack(const uint8_t *buf, size_t len, bool &out){
+    if(len != 1 || buf[0] > 1){ return false; }
+    out = buf[0];
+    return true;
+  }
+};
+
+template<>
+struct DataCodec<Time>{
+  static const DataPoint::Type TYPE = DataPoint::TIME;
+  static bool validate(const String &val){
+    return isInt(val, 0) || Time::isTime(val);
+  }
+  static bool parse(const String &val, Time &out){
+    if(!validate(val)){ return false; }
+    out = Time::toTime(val);
+    return true;
+  }
+  static size_t format(const Time &val, char *buf, size_t size, bool formatTime){
+    if(formatTime){ return Time::toChars(val.raw, buf, size); }
+    return snprintf(buf, size, "%llu", static_cast<unsigned long long>(val.raw));
+  }
+  //Always raw ms, formatting is left to the reader
+  static void encode(const Time &val, CborWriter &cbor){
+    cbor.value(static_cast<uint64_t>(val.raw));
+  }
+  static size_t pack(const Time &val, uint8_t *buf, size_t size){
+    return DataCodec<uint64_t>::pack(val.raw, buf, size);
+  }
+  static bool unpack(const uint8_t *buf, size_t len, Time &out){
+    uint64_t raw;
+    if(!DataCodec<uint64_t>::unpack(buf, len, raw)){ return false; }
+    out = Time{raw};
+    return true;
+  }
+};
+
+template<>
+struct DataCodec<String>{
+  static const DataPoint::Type TYPE = DataPoint::STR;
+  static bool validate(const String &val){ return true; }
+  static bool parse(const String &val, String &out){
+    out = val; //Already decoded by HttpRequest
+    return true;
+  }
+  static size_t format(const String &val, char *buf, size_t size, bool){
+    return snprintf(buf, size, "%s", val.c_str());
+  }
+  static void encode(const String &val, CborWriter &cbor){
+    cbor.text(val.c_str(), val.length());
+  }
+  //The chars without a terminator
+  static size_t pack(const String &val, uint8_t *buf, size_t size){
+    if(size < val.length()){ return 0; }
+    memcpy(buf, val.c_str(), val.length());
+    return val.length();
+  }
+  static bool unpack(const uint8_t *buf, size_t len, String &out){
+    out = String();
+    return out.concat(reinterpret_cast<const char*>(buf), len);
+  }
+};
+
+template<>
+struct DataCodec<IPAddress>{
+  static const DataPoint::Type TYPE = DataPoint::IP;
+  //Returns whether the string is an IPv4 address
+  static bool validate(const String &val){
+    IPAddress ip {};
+    if(!ip.fromString(val)){
+      return false;
+    }
+    return ip.type() == IPType::IPv4;
+  }
+  static bool parse(const String &val, IPAddress &out){
+    if(!validate(val)){ return false; }
+    out.fromString(val);
+    return true;
+  }
+  static size_t format(const IPAddress &val, char *buf, size_t size, bool){
+    return snprintf(buf, size, "%u.%u.%u.%u", val[0], val[1], val[2], val[3]);
+  }
+  static void encode(const IPAddress &val, CborWriter &cbor){
+    uint8_t octets[4] = {val[0], val[1], val[2], val[3]};
+    cbor.tag(CborWriter::TAG_IPV4);
+    cbor.bytes(octets, sizeof(octets));
+  }
+  static size_t pack(const IPAddress &val, uint8_t *buf, size_t size){
+    if(size < 4){ return 0; }
+    for(uint8_t i = 0; i < 4; ++i){ buf[i] = val[i]; }
+    return 4;
+  }
+  static bool unpack(const uint8_t *buf, size_t len, IPAddress &out){
+    if(len != 4){ return false; }
+    out = IPAddress(buf[0], buf[1], buf[2], buf[3]);
+    return true;
+  }
+};
+
+//Data point for a variable of type T
+//Conversions are picked at compile time through DataCodec<T>
+template<typename T>
+struct TypedDataPoint : public DataPoint{
+  using Codec = DataCodec<T>;
+  //Checks the new value before it's stored
+  //Return OK to have the value stored, SET if the function stored it itself, or BAD to reject it
+  using set_fn_t = status_t (*)(const T&);
+
+  T *data;
+  set_fn_t set;
+
+  //Used to set the value
+  //Returns whether the value was set
+  status_t setVal(const T &val){
+    if(!settable || data == nullptr){
+      return BAD;
+    }
+    status_t r = set == nullptr ? static_cast<status_t>(OK) : set(val);
+    if(r == OK){
+      *data = val;
+    }
+    if(r != BAD){ sync(); }
+    return r;
+  }
+
+  bool sync() override {
+    if(data == nullptr || *data == _last){ return false; }
+    _last = *data;
+    stamp();
+    return true;
+  }
+
+  bool validateData(const String &val) const override {
+    return Codec::validate(val);
+  }
+
+  status_t setValueStr(const String &str) override {
+    T val {};
+    if(!Codec::parse(str, val)){
+      return BAD;
+    }
+    return setVal(val);
+  }
+
+  size_t toChars(char *buf, size_t size, bool formatTime = false) const override {
+    if(data == nullptr){
+      return DataPoint::toChars(buf, size, formatTime);
+    }
+    return Codec::format(*data, buf, size, formatTime);
+  }
+
+  void writeCBORValue(CborWriter &cbor) const override {
+    if(data == nullptr){
+      DataPoint::writeCBORValue(cbor);
+      return;
+    }
+    Codec::encode(*data, cbor);
+  }
+
+  size_t toBytes(uint8_t *buf, size_t size) const override {
+    return data == nullptr ? 0 : Codec::pack(*data, buf, size);
+  }
+
+  status_t setValueBytes(const uint8_t *buf, size_t len) override {
+    T val {};
+    if(!Codec::unpack(buf, len, val)){
+      return BAD;
+    }
+    return setVal(val);
+  }
+
+  TypedDataPoint(const char *n, T *d, bool settable = false, set_fn_t s = nullptr, bool persistent = false) : DataPoint(n, Codec::TYPE, settable, persistent), data(d), set(s), _last(d == nullptr ? T{} : *d){}
+  //Const constructor (will be unmodifiable no matter what)
+  TypedDataPoint(const char *n, const T *d) : DataPoint(n, Codec::TYPE, false), data(const_cast<T*>(d)), set(nullptr), _last(d == nullptr ? T{} : *d){}
+  private:
+    T _last; //Value as of the last change, used to notice writes that skip the data point
 };
-const DataPoint DataPoint::NULL_DATAPOINT {"NULL", nullptr, DataPoint::Type::VOID, false};
-#endif //DATA_POINT_H
\ No newline at end of file
+#endif //DATA_POINT_H
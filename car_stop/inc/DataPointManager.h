@@ -3,57 +3,176 @@
 #ifndef DATAPOINT_MANAGER_H
 #define DATAPOINT_MANAGER_H
 #include "DataPoint.h"
+//Holds up to MAX data points and finds them by name through a minimal perfect hash
+//Only pointers are kept, the data points themselves should be statically allocated
+//The hash is (re)built the first time a lookup happens after data points were added,
+//so registering everything in setup() only pays for one build
+template<uint16_t MAX>
 class DataPointManager{
   public:
-    static const int MAX = 16;
+    static const uint16_t NOT_FOUND = UINT16_MAX;
     DataPointManager():
-      _count(0)
+      _count(0),
+      _indexed(true),
+      _useIndex(false)
     {
-      for(int i = 0; i < MAX; ++i){
+      for(uint16_t i = 0; i < MAX; ++i){
         _dataPoints[i] = nullptr;
       }
     }
-    ~DataPointManager(){
-      for(int i = 0; i < _count; ++i){
-        delete _dataPoints[i];
-      }
+    bool exists(const char *name, size_t len){
+      return _getIdx(name, len) != NOT_FOUND;
     }
-    bool exists(const String &name) const {
-      return _getIdx(name) < 0 ? false : true;
+    bool exists(const String &name){
+      return exists(name.c_str(), name.length());
     }
-    bool add(const DataPoint &dataPoint){
-      if(_count >= MAX || exists(dataPoint.name) || dataPoint.name == DataPoint::NULL_DATAPOINT.name){ return false; }
-      _dataPoints[_count++] = new DataPoint(dataPoint);
+    bool add(DataPoint &dataPoint){
+      if(_count >= MAX || dataPoint == DataPoint::NULL_DATAPOINT){ return false; }
+      //Linear check so adding doesn't force a rebuild of the index every time
+      for(uint16_t i = 0; i < _count; ++i){
+        if(*_dataPoints[i] == dataPoint){ return false; }
+      }
+      _dataPoints[_count++] = &dataPoint;
+      _indexed = false;
       return true;
     }
-    DataPoint::status_t set(const String &name, const String &val){
-      int idx = _getIdx(name);
-      if(idx < 0){ return DataPoint::BAD; }
+    DataPoint::status_t set(const char *name, size_t len, const String &val){
+      uint16_t idx = _getIdx(name, len);
+      if(idx == NOT_FOUND){ return DataPoint::BAD; }
       return _dataPoints[idx]->setValueStr(val);
     }
-    DataPoint::status_t set(const String &name, DataPoint::data_t val){
-      int idx = _getIdx(name);
-      if(idx < 0){ return DataPoint::BAD; }
-      return _dataPoints[idx]->setVal(val);
+    DataPoint::status_t set(const String &name, const String &val){
+      return set(name.c_str(), name.length(), val);
     }
-    const DataPoint& get(const String &name){
-      int idx = _getIdx(name);
-      if(idx < 0 || _dataPoints[idx] == nullptr){ return DataPoint::NULL_DATAPOINT; }
+    //Returns nullptr if there isn't a data point with the name
+    DataPoint* find(const char *name, size_t len){
+      uint16_t idx = _getIdx(name, len);
+      return idx == NOT_FOUND ? nullptr : _dataPoints[idx];
+    }
+    const DataPoint& get(const char *name, size_t len){
+      uint16_t idx = _getIdx(name, len);
+      if(idx == NOT_FOUND){ return DataPoint::NULL_DATAPOINT; }
       return *_dataPoints[idx];
     }
-    const DataPoint& get(uint8_t idx){
-      if(idx < 0 || idx >= _count){ return DataPoint::NULL_DATAPOINT; }
+    const DataPoint& get(const char *name){
+      return get(name, strlen(name));
+    }
+    const DataPoint& get(const String &name){
+      return get(name.c_str(), name.length());
+    }
+    const DataPoint& get(uint16_t idx){
+      if(idx >= _count){ return DataPoint::NULL_DATAPOINT; }
       return *_dataPoints[idx];
     }
-    uint8_t count() const { return _count; }
+    //Stamps every data point whose variable changed since the last sync
+    //Call after updating the variables (ie once per loop)
+    void sync(){
+      for(uint16_t i = 0; i < _count; ++i){
+        _dataPoints[i]->sync();
+      }
+    }
+    uint16_t count() const { return _count; }
   private:
+    static const uint16_t EMPTY = UINT16_MAX;
+    static const uint16_t MAX_SEED = UINT16_MAX;
     DataPoint* _dataPoints[MAX];
-    uint8_t _count;
-    int _getIdx(const String &name) const {
-      for(int i = 0; i < _count; ++i){
-        if(_dataPoints[i]->name == name){ return i; }
+    //Displacement seed for each bucket, 0 = empty bucket
+    uint16_t _seeds[MAX];
+    //Slot -> index into _dataPoints
+    uint16_t _slots[MAX];
+    uint16_t _count;
+    bool _indexed; //Whether the index is up to date with the data points
+    bool _useIndex; //Whether the last build succeeded
+
+    //FNV-1a with the seed folded into the offset basis, plus a final mix
+    static uint32_t _hash(uint32_t seed, const char *str, size_t len){
+      uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+      for(size_t i = 0; i < len; ++i){
+        h ^= static_cast<uint8_t>(str[i]);
+        h *= 16777619u;
+      }
+      h ^= h >> 16;
+      h *= 0x85EBCA6Bu;
+      h ^= h >> 13;
+      return h;
+    }
+
+    //Builds the perfect hash using hash and displace
+    //Keys are put in buckets by _hash(0), then the largest buckets are placed first by
+    //searching for a seed that moves every key in the bucket into a free slot
+    //Returns false if no seed could be found (lookups fall back to a linear scan)
+    bool _buildIndex(){
+      uint16_t bucketOf[MAX];
+      uint8_t bucketSize[MAX];
+      uint8_t maxSize = 0;
+      for(uint16_t i = 0; i < _count; ++i){
+        _seeds[i] = 0;
+        _slots[i] = EMPTY;
+        bucketSize[i] = 0;
+      }
+      for(uint16_t i = 0; i < _count; ++i){
+        const DataPoint &dp = *_dataPoints[i];
+        bucketOf[i] = _hash(0, dp.name, dp.nameLen) % _count;
+        uint8_t size = ++bucketSize[bucketOf[i]];
+        if(size > maxSize){ maxSize = size; }
+      }
+      for(uint8_t size = maxSize; size > 0; --size){
+        for(uint16_t b = 0; b < _count; ++b){
+          if(bucketSize[b] != size){ continue; }
+          if(!_placeBucket(b, size, bucketOf)){ return false; }
+        }
+      }
+      return true;
+    }
+
+    //Finds a seed for bucket b that puts all of its keys in free, distinct slots
+    bool _placeBucket(uint16_t b, uint8_t size, const uint16_t *bucketOf){
+      uint16_t slots[UINT8_MAX];
+      for(uint32_t seed = 1; seed <= MAX_SEED; ++seed){
+        uint8_t placed = 0;
+        for(uint16_t i = 0; i < _count && placed < size; ++i){
+          if(bucketOf[i] != b){ continue; }
+          const DataPoint &dp = *_dataPoints[i];
+          uint16_t slot = _hash(seed, dp.name, dp.nameLen) % _count;
+          if(_slots[slot] != EMPTY){ break; }
+          bool collides = false;
+          for(uint8_t j = 0; j < placed && !collides; ++j){
+            collides = slots[j] == slot;
+          }
+          if(collides){ break; }
+          slots[placed++] = slot;
+        }
+        if(placed != size){ continue; }
+        //Every key fits, claim the slots
+        placed = 0;
+        for(uint16_t i = 0; i < _count && placed < size; ++i){
+          if(bucketOf[i] != b){ continue; }
+          _slots[slots[placed++]] = i;
+        }
+        _seeds[b] = seed;
+        return true;
+      }
+      return false;
+    }
+
+    uint16_t _getIdx(const char *name, size_t len){
+      if(_count == 0 || name == nullptr){ return NOT_FOUND; }
+      if(!_indexed){
+        _useIndex = _buildIndex();
+        _indexed = true;
+      }
+      if(!_useIndex){ //Couldn't build the index (should never happen with sane names)
+        for(uint16_t i = 0; i < _count; ++i){
+          if(_dataPoints[i]->nameEquals(name, len)){ return i; }
+        }
+        return NOT_FOUND;
       }
-      return -1;
+      uint16_t seed = _seeds[_hash(0, name, len) % _count];
+      if(seed == 0){ return NOT_FOUND; } //Empty bucket
+      uint16_t idx = _slots[_hash(seed, name, len) % _count];
+      //Unknown names still land on some slot, so the name has to be confirmed
+      if(idx == EMPTY || !_dataPoints[idx]->nameEquals(name, len)){ return NOT_FOUND; }
+      return idx;
     }
 };
-#endif //DATAPOINT_MANAGER_H
\ No newline at end of file
+#endif //DATAPOINT_MANAGER_H
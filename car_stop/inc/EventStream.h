@@ -0,0 +1,181 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef EVENT_STREAM_H
+#define EVENT_STREAM_H
+#include "Networking.h"
+#include "DataPointManager.h"
+#include "BufferPrint.h"
+//Pushes data point changes to subscribed clients as Server-Sent Events
+//Every message is a "dp" event whose data is a JSON object shaped like /getall's
+//  {"seq":N,"name":{"val":"..","m":0,"t":0},...}
+//A data point is sent at most once every minInterval, changes in between go out together once it is due
+//Each message is serialized once then sent to every client without blocking
+//A client that falls more than PENDING_BYTES behind is dropped, EventSource reconnects on its own
+template<uint8_t MAX_CLIENTS, uint16_t MAX_POINTS>
+class EventStream{
+  public:
+    static const size_t MAX_MSG_BYTES = 2 * Net::SEND_BUF_BYTES; //Room for the snapshot sent on subscribe
+    static const uint16_t PENDING_BYTES = 256;
+    EventStream(Time::Time_t minInterval, Time::Time_t keepAlive = Time::second(15)):
+      _minInterval(minInterval),
+      _keepAlive(keepAlive),
+      _lastSend(0),
+      _clientCount(0)
+    {
+      for(uint16_t i = 0; i < MAX_POINTS; ++i){
+        _sentSeq[i] = 0;
+        _sentTime[i] = 0;
+      }
+    }
+
+    //Takes client as a subscriber and sends it the current value of every data point
+    //Returns false if every slot is taken (or the snapshot doesn't fit), the client is left untouched in that case
+    //The web server must not end the client if this succeeds (see WebServer::detachClient)
+    bool subscribe(WiFiClient &client, DataPointManager<MAX_POINTS> &dps){
+      Subscriber *sub = nullptr;
+      for(uint8_t i = 0; i < MAX_CLIENTS && sub == nullptr; ++i){
+        if(!_subs[i].active){ sub = &_subs[i]; }
+      }
+      if(sub == nullptr){ return false; }
+      //Header, retry and snapshot go out in one write
+      BufferPrint msg{_msg, MAX_MSG_BYTES};
+      Net::writeHeader(msg, Net::HTTP_RES_OK, "text/event-stream");
+      msg.print("Cache-Control: no-cache\r\n\r\n"); //No Connection header, the stream lasts as long as the connection
+      msg.print("retry: 2000\n\n"); //Reconnect delay for the browser
+      msg.print("event: dp\ndata: ");
+      char buf[128];
+      {
+        JsonWriter json{msg, buf, sizeof(buf)};
+        json.beginObject();
+        json.key("seq");
+        json.value(DataPoint::curSeq());
+        for(uint16_t i = 0; i < dps.count(); ++i){ dps.get(i).writeJSON(json, true); }
+        json.endObject();
+      }
+      msg.print("\n\n");
+      if(msg.overflow){
+        println("Event snapshot overflow");
+        return false;
+      }
+      client.write(reinterpret_cast<const uint8_t*>(_msg), msg.len);
+      sub->client = client;
+      sub->pendingLen = 0;
+      sub->active = true;
+      ++_clientCount;
+      return true;
+    }
+
+    //Sends whatever is due to the subscribers, call once per loop after DataPointManager::sync()
+    void poll(DataPointManager<MAX_POINTS> &dps){
+      if(_clientCount == 0){ return; }
+      for(uint8_t i = 0; i < MAX_CLIENTS; ++i){
+        if(_subs[i].active){ _flushPending(_subs[i]); }
+      }
+      Time::Time_t now = Time::now(false).raw;
+      size_t len = _buildMessage(dps, now);
+      if(len > 0){ _broadcast(reinterpret_cast<const uint8_t*>(_msg), len, now); }
+      else if(now - _lastSend >= _keepAlive){ //Comment line so dead connections get noticed
+        _broadcast(reinterpret_cast<const uint8_t*>(":\n\n"), 3, now);
+      }
+    }
+
+    uint8_t clientCount() const { return _clientCount; }
+  private:
+    struct Subscriber{
+      WiFiClient client;
+      uint8_t pending[PENDING_BYTES]; //Part of a message the socket didn't take yet
+      uint16_t pendingLen = 0;
+      bool active = false;
+    };
+
+    Time::Time_t _minInterval;
+    Time::Time_t _keepAlive;
+    Time::Time_t _lastSend;
+    Subscriber _subs[MAX_CLIENTS];
+    uint8_t _clientCount;
+    DataPoint::seq_t _sentSeq[MAX_POINTS]; //Change that was last sent for each data point
+    Time::Time_t _sentTime[MAX_POINTS];
+    char _msg[MAX_MSG_BYTES];
+
+    //Serializes every due data point into _msg
+    //Returns the length of the message, 0 if nothing is due
+    size_t _buildMessage(DataPointManager<MAX_POINTS> &dps, Time::Time_t now){
+      static const char HEAD[] = "event: dp\ndata: ";
+      static const size_t TAIL_BYTES = 3; //"}\n\n"
+      BufferPrint msg{_msg, MAX_MSG_BYTES};
+      msg.print(HEAD);
+      bool any = false;
+      char buf[128];
+      JsonWriter json{msg, buf, sizeof(buf)};
+      json.beginObject();
+      json.key("seq");
+      json.value(DataPoint::curSeq());
+      for(uint16_t i = 0; i < dps.count(); ++i){
+        const DataPoint &dp {dps.get(i)};
+        if(!dp.changedSince(_sentSeq[i]) || now - _sentTime[i] < _minInterval){ continue; }
+        json.flush();
+        //Worst case size of the member (every char escaped), leave the rest for the next message
+        if(msg.room() < dp.nameLen + DataPoint::MAX_STR_LEN * 6 + 32 + TAIL_BYTES){ break; }
+        dp.writeJSON(json, true);
+        _sentSeq[i] = dp.changeSeq;
+        _sentTime[i] = now;
+        any = true;
+      }
+      if(!any){ return 0; }
+      json.endObject();
+      json.flush();
+      msg.print("\n\n");
+      if(msg.overflow){
+        println("Event message overflow");
+        return 0;
+      }
+      return msg.len;
+    }
+
+    void _broadcast(const uint8_t *data, size_t len, Time::Time_t now){
+      _lastSend = now;
+      for(uint8_t i = 0; i < MAX_CLIENTS; ++i){
+        Subscriber &sub = _subs[i];
+        if(!sub.active){ continue; }
+        size_t sent = 0;
+        if(sub.pendingLen == 0){ //Nothing queued so it can go straight to the socket
+          int res = Net::sendNoWait(sub.client, data, len);
+          if(res < 0){
+            _drop(sub);
+            continue;
+          }
+          sent = res;
+        }
+        if(sent == len){ continue; }
+        if(sub.pendingLen + len - sent > PENDING_BYTES){ //Too far behind
+          _drop(sub);
+          continue;
+        }
+        memcpy(sub.pending + sub.pendingLen, data + sent, len - sent);
+        sub.pendingLen += len - sent;
+      }
+    }
+
+    void _flushPending(Subscriber &sub){
+      if(!sub.client.connected()){
+        _drop(sub);
+        return;
+      }
+      if(sub.pendingLen == 0){ return; }
+      int res = Net::sendNoWait(sub.client, sub.pending, sub.pendingLen);
+      if(res < 0){
+        _drop(sub);
+        return;
+      }
+      sub.pendingLen -= res;
+      memmove(sub.pending, sub.pending + res, sub.pendingLen);
+    }
+
+    void _drop(Subscriber &sub){
+      sub.client.stop();
+      sub.active = false;
+      sub.pendingLen = 0;
+      --_clientCount;
+    }
+};
+#endif //EVENT_STREAM_H
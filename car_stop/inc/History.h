@@ -0,0 +1,139 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef HISTORY_H
+#define HISTORY_H
+#include <stdint.h>
+#include "Time.h"
+#include "JsonWriter.h"
+#include "SampleLog.h"
+//Fixed size ring buffer, overwrites the oldest item when full
+template<typename T, uint16_t N>
+class Ring{
+  public:
+    Ring() : _start(0), _size(0){}
+    void push(const T &item){
+      if(_size < N){
+        _items[(_start + _size) % N] = item;
+        ++_size;
+        return;
+      }
+      _items[_start] = item;
+      _start = (_start + 1) % N;
+    }
+    //0 is the oldest item
+    const T& at(uint16_t idx) const { return _items[(_start + idx) % N]; }
+    uint16_t size() const { return _size; }
+    static uint16_t capacity() { return N; }
+  private:
+    T _items[N];
+    uint16_t _start;
+    uint16_t _size;
+};
+
+//Interface used to serve a history without knowing its sizes
+class HistoryBase{
+  public:
+    //Adds a sample taken at time t
+    virtual void add(Time t, int32_t value) = 0;
+    //Writes every sample and bucket at or after from as members of the JSON object being written
+    //  samples: [[time, value], ...]
+    //  seconds, minutes: [[start time, min, max, mean], ...]
+    virtual void writeJSON(JsonWriter &json, Time from) const = 0;
+};
+
+//History of a value that fits in a fixed amount of memory
+//Keeps the latest raw samples compressed in SAMPLE_BLOCKS blocks (see SampleLog),
+//plus min/max/mean for the latest SECONDS seconds and MINUTES minutes
+//Older data drops out of each tier as it fills, so each tier covers a longer time at a coarser resolution
+template<uint16_t SAMPLE_BLOCKS, uint16_t SECONDS, uint16_t MINUTES>
+class History : public HistoryBase{
+  public:
+    static const uint16_t SAMPLE_BLOCK_BYTES = 128;
+    //Summary of the samples in a period
+    struct Bucket{
+      Time::Time_t start;
+      int32_t min, max, mean;
+    };
+    //RAM used by the stored data
+    static const size_t BYTES = sizeof(SampleLog<SAMPLE_BLOCKS, SAMPLE_BLOCK_BYTES>) + sizeof(Ring<Bucket, SECONDS>) + sizeof(Ring<Bucket, MINUTES>);
+
+    void add(Time t, int32_t value) override {
+      _samples.append(t.raw, value);
+      Time::Time_t second = t.raw - t.raw % Time::MS_IN_SEC;
+      if(_curSecond.count > 0 && _curSecond.start != second){
+        _closeSecond();
+      }
+      _curSecond.add(second, value, value, value, 1);
+    }
+
+    void writeJSON(JsonWriter &json, Time from) const override {
+      json.key("samples");
+      json.beginArray();
+      _samples.forEach(from.raw, [&json](Time::Time_t time, int32_t value){
+        json.beginArray();
+        json.value(static_cast<uint64_t>(time));
+        json.value(static_cast<int64_t>(value));
+        json.endArray();
+      });
+      json.endArray();
+      json.key("seconds");
+      _writeBuckets(json, _seconds, from);
+      json.key("minutes");
+      _writeBuckets(json, _minutes, from);
+    }
+  private:
+    //Bucket that is still being filled
+    struct Accumulator{
+      Time::Time_t start = 0;
+      int32_t min = 0, max = 0;
+      int64_t sum = 0;
+      uint32_t count = 0;
+      void add(Time::Time_t s, int32_t mn, int32_t mx, int64_t sm, uint32_t cnt){
+        if(count == 0){
+          start = s;
+          min = mn;
+          max = mx;
+        }
+        if(mn < min){ min = mn; }
+        if(mx > max){ max = mx; }
+        sum += sm;
+        count += cnt;
+      }
+      Bucket close(){
+        Bucket bucket {start, min, max, static_cast<int32_t>(sum / count)};
+        count = 0;
+        sum = 0;
+        return bucket;
+      }
+    };
+    SampleLog<SAMPLE_BLOCKS, SAMPLE_BLOCK_BYTES> _samples;
+    Ring<Bucket, SECONDS> _seconds;
+    Ring<Bucket, MINUTES> _minutes;
+    Accumulator _curSecond, _curMinute;
+
+    void _closeSecond(){
+      Time::Time_t minute = _curSecond.start - _curSecond.start % Time::MS_IN_MIN;
+      if(_curMinute.count > 0 && _curMinute.start != minute){
+        _minutes.push(_curMinute.close());
+      }
+      _curMinute.add(minute, _curSecond.min, _curSecond.max, _curSecond.sum, _curSecond.count);
+      _seconds.push(_curSecond.close());
+    }
+
+    template<uint16_t N>
+    static void _writeBuckets(JsonWriter &json, const Ring<Bucket, N> &buckets, Time from){
+      json.beginArray();
+      for(uint16_t i = 0; i < buckets.size(); ++i){
+        const Bucket &bucket = buckets.at(i);
+        if(bucket.start < from.raw){ continue; }
+        json.beginArray();
+        json.value(static_cast<uint64_t>(bucket.start));
+        json.value(static_cast<int64_t>(bucket.min));
+        json.value(static_cast<int64_t>(bucket.max));
+        json.value(static_cast<int64_t>(bucket.mean));
+        json.endArray();
+      }
+      json.endArray();
+    }
+};
+#endif //HISTORY_H
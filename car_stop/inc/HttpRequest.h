@@ -0,0 +1,348 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef HTTP_REQUEST_H
+#define HTTP_REQUEST_H
+#include <Arduino.h>
+#include <stdint.h>
+#include "WebPath.h"
+//Chars inside another buffer, not null terminated
+//data is nullptr if the view doesn't point at anything (ie a missing parameter)
+struct StrView : public Printable{
+  const char *data;
+  uint16_t len;
+  StrView() : data(nullptr), len(0){}
+  StrView(const char *d, uint16_t l) : data(d), len(l){}
+  bool empty() const { return len == 0; }
+  bool equals(const char *str) const { return strlen(str) == len && (len == 0 || memcmp(data, str, len) == 0); }
+  bool equalsIgnoreCase(const char *str) const { return strlen(str) == len && (len == 0 || strncasecmp(data, str, len) == 0); }
+  bool contains(const char *str) const {
+    size_t strLen = strlen(str);
+    for(size_t i = 0; i + strLen <= len; ++i){
+      if(memcmp(data + i, str, strLen) == 0){ return true; }
+    }
+    return false;
+  }
+  //Parses an unsigned decimal number
+  //Returns false if the view isn't one or it doesn't fit in out
+  bool toUInt(uint64_t &out) const {
+    if(len == 0){ return false; }
+    out = 0;
+    for(uint16_t i = 0; i < len; ++i){
+      if(!isDigit(data[i])){ return false; }
+      uint64_t next = out * 10 + (data[i] - '0');
+      if(next / 10 != out){ return false; } //Overflow
+      out = next;
+    }
+    return true;
+  }
+  //Copy for the APIs that need a String
+  String toString() const {
+    String str{};
+    str.concat(data, len);
+    return str;
+  }
+  size_t printTo(Print &p) const override { return p.write(reinterpret_cast<const uint8_t*>(data), len); }
+};
+
+//HTTP request parsed incrementally, bytes are fed in as they arrive
+//The request line and the kept headers are stored in place in one fixed buffer, nothing is allocated
+//Method, path, query parameters and headers are views into that buffer
+//Percent encoding in the path and query is decoded in the same pass
+//Only Host and the headers named in reset() are kept, the rest are skipped without using the buffer
+//The body (if any) isn't read
+class HttpRequest{
+  public:
+    static const uint16_t MAX_BYTES = 512; //Request line plus kept headers
+    static const uint16_t MAX_HEADER_BYTES = 4096; //All headers, kept or not
+    static const uint8_t MAX_PARAMS = 12;
+    static const uint8_t MAX_HEADERS = 10;
+    enum class Result : uint8_t{
+      NEED_MORE, //Not complete yet
+      DONE,
+      URI_TOO_LONG,
+      HEADERS_TOO_LARGE,
+      BAD
+    };
+    HttpRequest(){ reset(nullptr, 0); }
+
+    //Starts a new request
+    //headerNames are the names of the headers to keep, they have to stay valid
+    void reset(const char *const *headerNames, uint8_t headerCount){
+      _headerNames = headerNames;
+      _headerCount = headerCount < MAX_HEADERS ? headerCount : MAX_HEADERS;
+      _state = State::METHOD;
+      _len = 0;
+      _tokenStart = 0;
+      _pct = 0;
+      _headerBytes = 0;
+      _method = WebPath::NONE;
+      _http10 = false;
+      _path = StrView();
+      _host = StrView();
+      _paramCount = 0;
+      _paramsDropped = false;
+      _curHeader = NO_HEADER;
+      for(uint8_t i = 0; i < MAX_HEADERS; ++i){ _headerValues[i] = StrView(); }
+    }
+
+    //Parses data up to the end of the request
+    //consumed is set to the number of bytes used, anything after them belongs to the next request
+    //Once a result other than NEED_MORE is returned, reset() has to be called before feeding more
+    Result feed(const uint8_t *data, size_t len, size_t &consumed){
+      consumed = 0;
+      if(_state == State::FINISHED){ return Result::BAD; }
+      while(consumed < len){
+        Result res = _step(static_cast<char>(data[consumed++]));
+        if(res != Result::NEED_MORE){
+          _state = State::FINISHED;
+          return res;
+        }
+      }
+      return Result::NEED_MORE;
+    }
+
+    WebPath::method_t method() const { return _method; }
+    //Whether the client spoke HTTP/1.0 instead of 1.1
+    bool http10() const { return _http10; }
+    const StrView& path() const { return _path; }
+    //Empty if the client didn't send it
+    const StrView& host() const { return _host; }
+    uint8_t paramCount() const { return _paramCount; }
+    const StrView& paramName(uint8_t idx) const { return _params[idx].name; }
+    const StrView& paramValue(uint8_t idx) const { return _params[idx].value; }
+    //Whether the query had more than MAX_PARAMS parameters (the rest were dropped)
+    bool paramsDropped() const { return _paramsDropped; }
+    bool hasParam(const char *name) const { return _findParam(name) != nullptr; }
+    //Value of the last parameter called name, data is nullptr if there isn't one
+    StrView param(const char *name) const {
+      const Param *p = _findParam(name);
+      return p == nullptr ? StrView() : p->value;
+    }
+    //Value of a kept header, empty if the client didn't send it or it isn't kept
+    StrView header(const char *name) const {
+      for(uint8_t i = 0; i < _headerCount; ++i){
+        if(strcasecmp(_headerNames[i], name) == 0){ return _headerValues[i]; }
+      }
+      return StrView();
+    }
+  private:
+    static const uint8_t NO_HEADER = UINT8_MAX;
+    static const uint8_t HOST_HEADER = UINT8_MAX - 1;
+    static const uint8_t MAX_METHOD_LEN = 7;
+    static const uint8_t MAX_VERSION_LEN = 9; //HTTP/1.1 plus '\r'
+    static const uint8_t MAX_HEADER_NAME_LEN = 32; //Longer names are never kept
+    enum class State : uint8_t{
+      METHOD,
+      PATH,
+      PARAM_NAME,
+      PARAM_VALUE,
+      VERSION,
+      HEADER_START, //Start of a header line (or the blank line that ends them)
+      HEADER_NAME,
+      HEADER_VALUE_START, //Whitespace before the value
+      HEADER_VALUE,
+      HEADER_SKIP, //Rest of a header that isn't kept
+      FINISHED
+    };
+    struct Param{
+      StrView name;
+      StrView value;
+    };
+    char _buf[MAX_BYTES];
+    uint16_t _len;
+    uint16_t _tokenStart; //Where the token being read starts in _buf
+    uint16_t _nameEnd; //End of the parameter name being read
+    State _state;
+    uint8_t _pct; //Chars of a %XX sequence seen, 0 when not in one
+    uint8_t _pctVal;
+    uint16_t _headerBytes;
+    WebPath::method_t _method;
+    bool _http10;
+    StrView _path;
+    StrView _host;
+    Param _params[MAX_PARAMS];
+    uint8_t _paramCount;
+    bool _paramsDropped;
+    const char *const *_headerNames;
+    uint8_t _headerCount;
+    StrView _headerValues[MAX_HEADERS];
+    uint8_t _curHeader; //Header whose value is being read
+
+    const Param* _findParam(const char *name) const {
+      for(uint8_t i = _paramCount; i > 0; --i){
+        if(_params[i - 1].name.equals(name)){ return &_params[i - 1]; }
+      }
+      return nullptr;
+    }
+
+    StrView _token() const { return StrView(_buf + _tokenStart, _len - _tokenStart); }
+
+    bool _put(char c){
+      if(_len >= MAX_BYTES){ return false; }
+      _buf[_len++] = c;
+      return true;
+    }
+
+    static int8_t _hexVal(char c){
+      if(c >= '0' && c <= '9'){ return c - '0'; }
+      if(c >= 'a' && c <= 'f'){ return c - 'a' + 10; }
+      if(c >= 'A' && c <= 'F'){ return c - 'A' + 10; }
+      return -1;
+    }
+
+    //Handles a char of the path or query
+    //Returns BAD/URI_TOO_LONG on errors, DONE if c was eaten by a %XX sequence or stored, NEED_MORE if the caller should handle it
+    Result _uriChar(char c){
+      if(_pct > 0){
+        int8_t val = _hexVal(c);
+        if(val < 0){ return Result::BAD; }
+        _pctVal = (_pctVal << 4) | val;
+        if(++_pct < 3){ return Result::DONE; }
+        _pct = 0;
+        if(_pctVal == 0){ return Result::BAD; } //No nulls, values end up in C strings
+        return _put(_pctVal) ? Result::DONE : Result::URI_TOO_LONG;
+      }
+      if(c == '%'){
+        _pct = 1;
+        _pctVal = 0;
+        return Result::DONE;
+      }
+      if(c == '\r' || c == '\n' || c == '\0'){ return Result::BAD; }
+      if(c == ' ' || c == '?' || c == '&' || c == '='){ return Result::NEED_MORE; }
+      return _put(c) ? Result::DONE : Result::URI_TOO_LONG;
+    }
+
+    //Ends the parameter being read (name up to _nameEnd, value after it)
+    void _endParam(bool hasValue){
+      uint16_t nameEnd = hasValue ? _nameEnd : _len;
+      if(nameEnd == _tokenStart){ //No name (ie "&&"), drop it
+        _len = _tokenStart;
+        return;
+      }
+      if(_paramCount >= MAX_PARAMS){
+        _paramsDropped = true;
+        _len = _tokenStart;
+        return;
+      }
+      Param &p = _params[_paramCount++];
+      p.name = StrView(_buf + _tokenStart, nameEnd - _tokenStart);
+      p.value = hasValue ? StrView(_buf + _nameEnd, _len - _nameEnd) : StrView(_buf + _len, 0);
+      _tokenStart = _len;
+    }
+
+    Result _step(char c){
+      switch(_state){
+        case State::METHOD:
+          if(c == ' '){
+            StrView name {_token()};
+            if(name.equals("GET")){ _method = WebPath::GET; }
+            else if(name.equals("POST")){ _method = WebPath::POST; }
+            _len = _tokenStart;
+            _state = State::PATH;
+            return Result::NEED_MORE;
+          }
+          if(c < 'A' || c > 'Z' || _len - _tokenStart >= MAX_METHOD_LEN){ return Result::BAD; }
+          _put(c);
+          return Result::NEED_MORE;
+        case State::PATH:{
+          Result res = _uriChar(c);
+          if(res != Result::NEED_MORE){ return res == Result::DONE ? Result::NEED_MORE : res; }
+          if(c != '?' && c != ' '){ //'&' and '=' are just chars in the path
+            return _put(c) ? Result::NEED_MORE : Result::URI_TOO_LONG;
+          }
+          _path = _token();
+          if(_path.empty() || _path.data[0] != '/'){ return Result::BAD; }
+          _tokenStart = _len;
+          _state = c == '?' ? State::PARAM_NAME : State::VERSION;
+          return Result::NEED_MORE;
+        }
+        case State::PARAM_NAME:
+        case State::PARAM_VALUE:{
+          Result res = _uriChar(c);
+          if(res != Result::NEED_MORE){ return res == Result::DONE ? Result::NEED_MORE : res; }
+          if(c == '='){
+            if(_state == State::PARAM_VALUE){ //Part of the value
+              return _put(c) ? Result::NEED_MORE : Result::URI_TOO_LONG;
+            }
+            _nameEnd = _len;
+            _state = State::PARAM_VALUE;
+            return Result::NEED_MORE;
+          }
+          if(c == '?'){ return _put(c) ? Result::NEED_MORE : Result::URI_TOO_LONG; }
+          _endParam(_state == State::PARAM_VALUE);
+          _state = c == '&' ? State::PARAM_NAME : State::VERSION;
+          return Result::NEED_MORE;
+        }
+        case State::VERSION:
+          if(c != '\n'){
+            if(_len - _tokenStart >= MAX_VERSION_LEN){ return Result::BAD; }
+            _put(c);
+            return Result::NEED_MORE;
+          }
+          {
+            StrView version {_token()};
+            if(version.len > 0 && version.data[version.len - 1] == '\r'){ --version.len; }
+            if(version.len != 8 || memcmp(version.data, "HTTP/1.", 7) != 0){ return Result::BAD; }
+            _http10 = version.data[7] == '0';
+          }
+          _len = _tokenStart;
+          _state = State::HEADER_START;
+          return Result::NEED_MORE;
+        default:
+          break;
+      }
+      //Headers
+      if(++_headerBytes > MAX_HEADER_BYTES){ return Result::HEADERS_TOO_LARGE; }
+      switch(_state){
+        case State::HEADER_START:
+          if(c == '\r'){ return Result::NEED_MORE; }
+          if(c == '\n'){ return Result::DONE; }
+          _tokenStart = _len;
+          _state = State::HEADER_NAME;
+          return _step(c);
+        case State::HEADER_NAME:
+          if(c == '\n'){ //No colon, ignore the line
+            _len = _tokenStart;
+            _state = State::HEADER_START;
+            return Result::NEED_MORE;
+          }
+          if(c != ':'){
+            if(_len - _tokenStart >= MAX_HEADER_NAME_LEN){ //Too long to be one that is kept
+              _len = _tokenStart;
+              _state = State::HEADER_SKIP;
+              return Result::NEED_MORE;
+            }
+            return _put(c) ? Result::NEED_MORE : Result::HEADERS_TOO_LARGE;
+          }
+          {
+            StrView name {_token()};
+            _curHeader = NO_HEADER;
+            if(name.equalsIgnoreCase("Host")){ _curHeader = HOST_HEADER; }
+            for(uint8_t i = 0; i < _headerCount && _curHeader == NO_HEADER; ++i){
+              if(name.equalsIgnoreCase(_headerNames[i])){ _curHeader = i; }
+            }
+          }
+          _len = _tokenStart;
+          _state = _curHeader == NO_HEADER ? State::HEADER_SKIP : State::HEADER_VALUE_START;
+          return Result::NEED_MORE;
+        case State::HEADER_VALUE_START:
+          if(c == ' ' || c == '\t'){ return Result::NEED_MORE; }
+          _tokenStart = _len;
+          _state = State::HEADER_VALUE;
+          return _step(c);
+        case State::HEADER_VALUE:
+          if(c != '\n'){ return _put(c) ? Result::NEED_MORE : Result::HEADERS_TOO_LARGE; }
+          while(_len > _tokenStart && (_buf[_len - 1] == '\r' || _buf[_len - 1] == ' ' || _buf[_len - 1] == '\t')){ --_len; }
+          if(_curHeader == HOST_HEADER){ _host = _token(); }
+          else{ _headerValues[_curHeader] = _token(); }
+          _state = State::HEADER_START;
+          return Result::NEED_MORE;
+        case State::HEADER_SKIP:
+          if(c == '\n'){ _state = State::HEADER_START; }
+          return Result::NEED_MORE;
+        default:
+          return Result::BAD;
+      }
+    }
+};
+#endif //HTTP_REQUEST_H
@@ -0,0 +1,137 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+#include <Arduino.h>
+#include <stdint.h>
+//Writes JSON straight into a fixed size buffer and sends it to out whenever the buffer fills up
+//Commas between members are added automatically
+//Nesting is limited to MAX_DEPTH levels
+class JsonWriter{
+  public:
+    static const uint8_t MAX_DEPTH = 32;
+    JsonWriter(Print &out, char *buf, size_t size):
+      _out(out),
+      _buf(buf),
+      _size(size),
+      _len(0),
+      _depth(0),
+      _hasMembers(0),
+      _afterKey(false)
+    {}
+    ~JsonWriter(){ flush(); }
+
+    void beginObject(){ _open('{'); }
+    void endObject(){ _close('}'); }
+    void beginArray(){ _open('['); }
+    void endArray(){ _close(']'); }
+
+    //Writes the key of the next object member
+    void key(const char *k, size_t len){
+      _separate();
+      _putString(k, len);
+      _put(':');
+      _afterKey = true;
+    }
+    void key(const char *k){ key(k, strlen(k)); }
+
+    //Writes a string value (escaped)
+    void value(const char *str, size_t len){
+      _separate();
+      _putString(str, len);
+    }
+    void value(const char *str){ value(str, strlen(str)); }
+    void value(uint64_t v){
+      char num[21];
+      int len = snprintf(num, sizeof(num), "%llu", static_cast<unsigned long long>(v));
+      raw(num, len);
+    }
+    void value(int64_t v){
+      char num[21];
+      int len = snprintf(num, sizeof(num), "%lld", static_cast<long long>(v));
+      raw(num, len);
+    }
+    void value(uint32_t v){ value(static_cast<uint64_t>(v)); }
+    void value(int32_t v){ value(static_cast<int64_t>(v)); }
+    void value(bool v){ v ? raw("true", 4) : raw("false", 5); }
+
+    //Writes an already formatted value (number, true, null, etc)
+    void raw(const char *str, size_t len){
+      _separate();
+      _write(str, len);
+    }
+
+    //Sends everything that is buffered
+    void flush(){
+      if(_len == 0){ return; }
+      _out.write(reinterpret_cast<const uint8_t*>(_buf), _len);
+      _len = 0;
+    }
+  private:
+    Print &_out;
+    char *_buf;
+    size_t _size;
+    size_t _len;
+    uint8_t _depth;
+    uint32_t _hasMembers; //Bit per level, set once the level has something in it
+    bool _afterKey; //A key was just written so the value doesn't need a comma
+
+    void _put(char c){
+      if(_len >= _size){ flush(); }
+      _buf[_len++] = c;
+    }
+    void _write(const char *str, size_t len){
+      while(len > 0){
+        if(_len >= _size){ flush(); }
+        size_t n = _size - _len < len ? _size - _len : len;
+        memcpy(_buf + _len, str, n);
+        _len += n;
+        str += n;
+        len -= n;
+      }
+    }
+    void _putString(const char *str, size_t len){
+      static const char HEX_CHARS[] = "0123456789abcdef";
+      _put('"');
+      size_t start = 0; //Start of the run of chars that don't need escaping
+      for(size_t i = 0; i < len; ++i){
+        uint8_t c = str[i];
+        if(c != '"' && c != '\\' && c >= 0x20){ continue; }
+        _write(str + start, i - start);
+        start = i + 1;
+        _put('\\');
+        if(c == '"' || c == '\\'){ _put(c); }
+        else{ //Control char
+          _write("u00", 3);
+          _put(HEX_CHARS[c >> 4]);
+          _put(HEX_CHARS[c & 0xF]);
+        }
+      }
+      _write(str + start, len - start);
+      _put('"');
+    }
+    //Adds a comma if this isn't the first member of the current level
+    void _separate(){
+      if(_afterKey){
+        _afterKey = false;
+        return;
+      }
+      if(_depth == 0){ return; }
+      uint32_t bit = 1ul << (_depth - 1);
+      if(_hasMembers & bit){ _put(','); }
+      _hasMembers |= bit;
+    }
+    void _open(char c){
+      _separate();
+      _put(c);
+      if(_depth < MAX_DEPTH){
+        ++_depth;
+        _hasMembers &= ~(1ul << (_depth - 1));
+      }
+    }
+    void _close(char c){
+      if(_depth > 0){ --_depth; }
+      _put(c);
+    }
+};
+#endif //JSON_WRITER_H
@@ -2,6 +2,7 @@
 //All Rights Reserved
 #ifndef LIGHT_H
 #define LIGHT_H
+#include "Time.h"
 //Base class for indicator light
 class Light{
   public:
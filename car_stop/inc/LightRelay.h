@@ -2,6 +2,7 @@
 //All Rights Reserved
 #ifndef LIGHT_RELAY_H
 #define LIGHT_RELAY_H
+#include "Light.h"
 //Relay controlling a light
 class LightRelay : public Light{
   public:
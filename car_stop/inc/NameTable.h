@@ -0,0 +1,142 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef NAME_TABLE_H
+#define NAME_TABLE_H
+#include <stdint.h>
+#include <string.h>
+//Fixed size hash table from DNS names in wire format to a T, case doesn't matter
+//Open addressing over SLOTS (a power of 2) slots, names are kept lowercase in a POOL_BYTES pool
+//An entry is either the name itself or a wildcard for every name under it (*.name)
+//find() looks the name up then each name it is under, one probe chain per label, so it doesn't get
+//slower with more entries
+template<uint16_t SLOTS, uint16_t POOL_BYTES, typename T>
+class NameTable{
+  static_assert((SLOTS & (SLOTS - 1)) == 0, "SLOTS has to be a power of 2");
+  public:
+    static const uint16_t MAX_ENTRIES = SLOTS / 2; //Every query misses a few times, misses get slow past half full
+
+    //Adds name or replaces its value
+    //Returns false if the table is full or name isn't a wire format name
+    bool add(const uint8_t *name, uint16_t length, bool wildcard, const T &value){
+      if(length == 0 || length > MAX_NAME_BYTES){ return false; }
+      uint8_t starts[MAX_LABELS];
+      int16_t labels = _labels(name, length, starts);
+      if(labels < 0){ return false; }
+      uint32_t hash = HASH_SEED;
+      for(int16_t i = labels - 1, end = length - 1; i >= 0; end = starts[i--]){
+        hash = _hashLabel(hash, name + starts[i], end - starts[i]);
+      }
+      Slot *slot = _probe(name, length, wildcard, hash);
+      if(slot->used){
+        slot->value = value;
+        return true;
+      }
+      if(_size >= MAX_ENTRIES || POOL_BYTES - _poolUsed < length){ return false; }
+      for(uint16_t i = 0; i < length; ++i){ _pool[_poolUsed + i] = _lower(name[i]); }
+      slot->used = true;
+      slot->wildcard = wildcard;
+      slot->hash = hash;
+      slot->offset = _poolUsed;
+      slot->length = length;
+      slot->value = value;
+      _poolUsed += length;
+      ++_size;
+      return true;
+    }
+
+    //Value of name's entry, or of the wildcard closest to it, nullptr if there isn't one
+    const T* find(const uint8_t *name, uint16_t length) const {
+      if(_size == 0 || length == 0 || length > MAX_NAME_BYTES){ return nullptr; }
+      uint8_t starts[MAX_LABELS];
+      int16_t labels = _labels(name, length, starts);
+      if(labels < 0){ return nullptr; }
+      //Labels are hashed from the last one so each adds to the hash of the name it is under
+      //The most specific entry wins, so going from the top down the last one found is it
+      const T *found = nullptr;
+      uint32_t hash = HASH_SEED;
+      for(int16_t i = labels - 1, end = length - 1; i >= 0; end = starts[i--]){
+        hash = _hashLabel(hash, name + starts[i], end - starts[i]);
+        const Slot *slot = _probe(name + starts[i], length - starts[i], i > 0, hash);
+        if(slot->used){ found = &slot->value; }
+      }
+      return found;
+    }
+
+    void clear(){
+      for(uint16_t i = 0; i < SLOTS; ++i){ _slots[i].used = false; }
+      _size = 0;
+      _poolUsed = 0;
+    }
+    uint16_t size() const { return _size; }
+  private:
+    static const uint16_t MAX_NAME_BYTES = 255;
+    static const uint8_t MAX_LABELS = MAX_NAME_BYTES / 2;
+    static const uint32_t HASH_SEED = 2166136261u;
+    static const uint32_t HASH_PRIME = 16777619u;
+    struct Slot{
+      uint32_t hash;
+      uint16_t offset; //Of the name in _pool
+      uint8_t length;
+      bool used = false;
+      bool wildcard;
+      T value;
+    };
+    Slot _slots[SLOTS];
+    uint8_t _pool[POOL_BYTES];
+    uint16_t _poolUsed = 0;
+    uint16_t _size = 0;
+
+    static uint8_t _lower(uint8_t c){ return c >= 'A' && c <= 'Z' ? c | 0x20 : c; } //ASCII only, like DNS
+
+    //Where each of name's labels starts, returns how many there are, -1 if they don't add up to length
+    static int16_t _labels(const uint8_t *name, uint16_t length, uint8_t *starts){
+      int16_t labels = 0;
+      uint16_t pos = 0;
+      while(name[pos] != 0){
+        starts[labels++] = pos;
+        pos += name[pos] + 1;
+        if(pos >= length){ return -1; }
+      }
+      return pos == length - 1 ? labels : -1;
+    }
+    //Adds a label (its length byte and characters) to hash, 4 bytes at a time from its end
+    //| 0x20 folds case, it also folds some other bytes together but the names are compared after
+    static uint32_t _hashLabel(uint32_t hash, const uint8_t *label, uint16_t length){
+      while(length >= 4){
+        length -= 4;
+        uint32_t word;
+        memcpy(&word, label + length, 4);
+        hash = (hash ^ (word | 0x20202020u)) * HASH_PRIME;
+      }
+      while(length > 0){
+        --length;
+        hash = (hash ^ (label[length] | 0x20u)) * HASH_PRIME;
+      }
+      return hash;
+    }
+
+    //Slot holding the entry, or the free one it would go in
+    //The table is never full (MAX_ENTRIES) so there always is one
+    Slot* _probe(const uint8_t *name, uint16_t length, bool wildcard, uint32_t hash){
+      return const_cast<Slot*>(static_cast<const NameTable*>(this)->_probe(name, length, wildcard, hash));
+    }
+    const Slot* _probe(const uint8_t *name, uint16_t length, bool wildcard, uint32_t hash) const {
+      uint32_t mixed = hash ^ (wildcard ? 0x9e3779b9u : 0); //Spread the low bits, a name and its wildcard land apart
+      mixed ^= mixed >> 16;
+      mixed *= 0x85ebca6bu;
+      mixed ^= mixed >> 13;
+      for(uint16_t idx = mixed & (SLOTS - 1);; idx = (idx + 1) & (SLOTS - 1)){
+        const Slot &slot = _slots[idx];
+        if(!slot.used){ return &slot; }
+        if(slot.hash == hash && slot.wildcard == wildcard && slot.length == length && _matches(slot, name)){ return &slot; }
+      }
+    }
+    bool _matches(const Slot &slot, const uint8_t *name) const {
+      const uint8_t *stored = _pool + slot.offset;
+      for(uint16_t i = 0; i < slot.length; ++i){
+        if(stored[i] != _lower(name[i])){ return false; }
+      }
+      return true;
+    }
+};
+#endif //NAME_TABLE_H
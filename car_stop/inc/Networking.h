@@ -3,19 +3,27 @@
 #ifndef NETWORKING_H
 #define NETWORKING_H
 #include <WiFi.h>
+#include <errno.h>
+#include <lwip/sockets.h>
 #include "DataPoint.h"
 #include "WebPath.h"
 namespace Net{
   const char *HTTP_VER = "1.1";
+  const char *HTTP_RES_SWITCHING = "101 Switching Protocols";
   const char *HTTP_RES_OK = "200 OK";
   const char *HTTP_RES_NO_CONTENT = "204 No Content";
+  const char *HTTP_RES_NOT_MODIFIED = "304 Not Modified";
   const char *HTTP_RES_BAD_REQ = "400 Bad Request";
   const char *HTTP_RES_FORB = "403 Forbidden";
   const char *HTTP_RES_NOT_FOUND = "404 Not Found";
   const char *HTTP_RES_BAD_METH = "405 Method Not Allowed";
   const char *HTTP_RES_URI_LEN = "414 URI Too Long";
+  const char *HTTP_RES_HEADERS_LEN = "431 Request Header Fields Too Large";
   const char *HTTP_RES_INTERN_ERR = "500 Internal Server Error";
   const char *HTTP_RES_NOT_IMPL = "501 Not Implemented";
+  const char *HTTP_RES_UNAVAILABLE = "503 Service Unavailable";
+
+  const char *CONTENT_CBOR = "application/cbor";
 
   struct Config{
     String wifiSSID, wifiPswd;
@@ -36,66 +44,59 @@ namespace Net{
 
   //WiFiServer webServer{WEBSERVER_PORT};
   //bool webServerRunning = 0;
-  const uint32_t MAX_REQ_BYTES = 512;
-
-  //Returns the value of the key
-  //Returns an empty string of the key wasnt found
-  String getKeyValue(String key, const String &str){
-    key += '='; //The keys have an = after them
-    int keyIdx = str.lastIndexOf(key); //Last index to get the last value it was set to
-    if(keyIdx == -1){
-      return {};
-    }
-    int endIdx = str.indexOf('&', keyIdx); //Stop at start of next key
-    if(endIdx == -1){
-      endIdx = str.length();
-    }
-    return str.substring(keyIdx + key.length(), endIdx); 
-  }
+  const size_t SEND_BUF_BYTES = 1024; //Size of the buffer responses are written into before sending
 
-  //Reads from c until delim is found, no bytes are left, or maxSize is surpassed
-  //Returns number of bytes read, -1 if maxSize was surpassed
-  //If maxSize was surpassed out will not be modified
-  int bufReadStringUntil(WiFiClient &c, String &out, char delim, size_t maxSize){
-    char *buffer = new char[maxSize+1]; //+1 for null terminator
-    buffer[maxSize] = '\0'; //Terminate end of buffer
-    size_t bytesRead = c.readBytesUntil(delim, buffer, maxSize+1);
-    if(bytesRead > maxSize){ //We surpassed maxSize
-      delete[] buffer;
-      return -1;
-    }
-    buffer[bytesRead] = '\0'; //Terminate string
-    out = buffer;
-    delete[] buffer;
-    return bytesRead;
-  }
+  const int32_t LENGTH_UNKNOWN = -1; //Body ends when the connection does
+  const int32_t NO_BODY = -2; //Response that never has a body (ie 304)
 
-  //Sends resposne header to the client
+  //Writes the status line and the content headers, more headers can follow (see endHeader)
   //code is the response code
-  //contentType is the type of the content (ie "text/html")
+  //contentType is the type of the content (ie "text/html"), left out if nullptr
   //If allowedMethods is set then the 'Allow' header will be included with it
-  void sendHeader(WiFiClient &client, const char *code, const char *contentType, uint8_t allowedMethods = WebPath::NONE){
-    client.print("HTTP/");
-    client.print(HTTP_VER);
-    client.print(' ');
-    client.println(code);
-    client.print("Content-Type: ");
-    client.print(contentType);
-    client.println("; charset=utf-8");
+  void writeHeader(Print &out, const char *code, const char *contentType, uint8_t allowedMethods = WebPath::NONE){
+    out.print("HTTP/");
+    out.print(HTTP_VER);
+    out.print(' ');
+    out.println(code);
+    if(contentType != nullptr){
+      out.print("Content-Type: ");
+      out.print(contentType);
+      if(strcmp(contentType, CONTENT_CBOR) != 0){ out.print("; charset=utf-8"); } //Binary has no charset
+      out.println();
+    }
     if(allowedMethods != WebPath::NONE){
-      client.print("Allow: ");
+      out.print("Allow: ");
       if(allowedMethods & WebPath::GET){
-        client.print("GET");
+        out.print("GET");
         if(allowedMethods & WebPath::POST){
-          client.print(", POST");
+          out.print(", POST");
         }
       }
       else if(allowedMethods & WebPath::POST){ //Dont include the ', ' if post is the only method
-        client.print("POST");
+        out.print("POST");
       }
-      client.println();
+      out.println();
     }
-    client.println("Connection: close\n");
+  }
+
+  //Writes the framing headers and the blank line that ends the header
+  //contentLength is the length of the body, LENGTH_UNKNOWN or NO_BODY
+  //chunked is whether the body is sent in chunks, contentLength is ignored then
+  //keepAlive is only honored when the end of the body is known
+  void endHeader(Print &out, int32_t contentLength, bool keepAlive, bool chunked = false){
+    if(chunked){ out.println("Transfer-Encoding: chunked"); }
+    else if(contentLength >= 0){
+      out.print("Content-Length: ");
+      out.println(static_cast<long>(contentLength));
+    }
+    out.println(keepAlive && (chunked || contentLength != LENGTH_UNKNOWN) ? "Connection: keep-alive" : "Connection: close");
+    out.println();
+  }
+
+  //Sends resposne header to the client, the connection is closed after the body
+  void sendHeader(WiFiClient &client, const char *code, const char *contentType, uint8_t allowedMethods = WebPath::NONE){
+    writeHeader(client, code, contentType, allowedMethods);
+    endHeader(client, LENGTH_UNKNOWN, false);
   }
 
   void sendHeaderAndBody(WiFiClient &client, const char *code){
@@ -214,10 +215,20 @@ namespace Net{
     //connectToWifi(wifiSSID, wifiPswd, WIFI_CONN_TRIES);
   }
 
+  //Sends as much of data as the socket will take right now
+  //Returns the number of bytes sent (0 if the socket buffer is full), -1 if the connection is broken
+  int sendNoWait(WiFiClient &client, const uint8_t *data, size_t len){
+    int fd = client.fd();
+    if(fd < 0){ return -1; }
+    int sent = send(fd, data, len, MSG_DONTWAIT);
+    if(sent < 0){ return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1; }
+    return sent;
+  }
+
   //Disconnects a client
+  //Unread input is thrown away first, closing with it still buffered would reset the connection
   void endClient(WiFiClient &client){
     client.flush();
-    delay(10);
     client.stop();
   }
 };
@@ -0,0 +1,61 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+#include <stdint.h>
+#include "Time.h"
+//Token bucket per client IP, kept in a fixed table of SLOTS buckets
+//Each bucket holds up to burst tokens and gets rate tokens a second back, a request takes one
+//An IP that isn't in the table takes the bucket of the one seen longest ago (starting full)
+template<uint8_t SLOTS>
+class RateLimiter{
+  public:
+    //rate of 0 turns limiting off
+    RateLimiter(uint16_t rate, uint16_t burst) : _rate(rate), _burst(burst){}
+
+    void configure(uint16_t rate, uint16_t burst){
+      _rate = rate;
+      _burst = burst;
+      for(uint8_t i = 0; i < SLOTS; ++i){ _buckets[i].used = false; }
+    }
+
+    //Takes a token from ip's bucket
+    //Returns false if the bucket is empty
+    bool allow(uint32_t ip, Time::Time_t now){
+      if(_rate == 0){ return true; }
+      Bucket *bucket = nullptr;
+      Bucket *oldest = &_buckets[0];
+      for(uint8_t i = 0; i < SLOTS && bucket == nullptr; ++i){
+        Bucket &b = _buckets[i];
+        if(b.used && b.ip == ip){ bucket = &b; }
+        else if(oldest->used && (!b.used || b.last < oldest->last)){ oldest = &b; }
+      }
+      uint32_t full = static_cast<uint32_t>(_burst) * SCALE;
+      if(bucket == nullptr){
+        bucket = oldest;
+        bucket->used = true;
+        bucket->ip = ip;
+        bucket->tokens = full;
+      }
+      else{ //Refill for the time since it was last used, rate tokens/s is rate milli-tokens/ms
+        uint64_t tokens = bucket->tokens + static_cast<uint64_t>(now - bucket->last) * _rate;
+        bucket->tokens = tokens > full ? full : tokens;
+      }
+      bucket->last = now;
+      if(bucket->tokens < SCALE){ return false; }
+      bucket->tokens -= SCALE;
+      return true;
+    }
+  private:
+    static const uint32_t SCALE = 1000; //Tokens are kept in thousandths
+    struct Bucket{
+      uint32_t ip = 0;
+      uint32_t tokens = 0;
+      Time::Time_t last = 0;
+      bool used = false;
+    };
+    uint16_t _rate;
+    uint16_t _burst;
+    Bucket _buckets[SLOTS];
+};
+#endif //RATE_LIMITER_H
@@ -0,0 +1,195 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef RESPONSE_H
+#define RESPONSE_H
+#include "Util.h"
+#include "Networking.h"
+#include "BufferPrint.h"
+//Response to a request, what web path callbacks write into
+//The status line, the headers and the body are collected in one buffer and sent with a single write
+//when the callback returns, with a Content-Length so the connection can stay open for the next request
+//A body that outgrows the buffer is sent a buffer at a time as chunks (Transfer-Encoding: chunked),
+//or for HTTP/1.0 clients without a length and the connection is closed after it
+class Response : public Print{
+  public:
+    static const size_t MAX_BODY_BYTES = 2048;
+    static const size_t MAX_HEADER_BYTES = 512;
+    static const uint8_t MAX_EXTRA_HEADERS = 4;
+    static const size_t SEGMENT_BYTES = 1436; //lwIP's TCP_MSS on the ESP32 (a macro there, hence the name)
+    struct Stats{
+      uint32_t responses = 0;
+      uint32_t chunked = 0; //Responses sent as chunks
+      uint32_t writes = 0; //Writes to the socket
+      uint32_t segments = 0; //TCP segments those writes take at least
+    };
+    Response() : _client(nullptr){ reset(nullptr, false, false); }
+
+    //Starts a response on client
+    //keepAlive is whether the request allows the connection to stay open afterwards
+    //chunkedAllowed is whether the client understands chunked bodies (HTTP/1.1)
+    void reset(WiFiClient *client, bool keepAlive, bool chunkedAllowed){
+      _client = client;
+      _keepAlive = keepAlive;
+      _chunkedAllowed = chunkedAllowed;
+      _code = nullptr;
+      _contentType = nullptr;
+      _allowedMethods = WebPath::NONE;
+      _headerSent = false;
+      _chunked = false;
+      _length = Net::LENGTH_UNKNOWN;
+      _bodyLen = 0;
+      _extraCount = 0;
+    }
+
+    //Adds a header to the response, has to be called before the body is sent
+    //name and value have to stay valid until the response is finished (ie string literals)
+    bool header(const char *name, const char *value){
+      if(_headerSent || _extraCount >= MAX_EXTRA_HEADERS){ return false; }
+      _extraNames[_extraCount] = name;
+      _extraValues[_extraCount++] = value;
+      return true;
+    }
+
+    //Sets the status line and content type, has to be called before writing the body
+    void begin(const char *code, const char *contentType, uint8_t allowedMethods = WebPath::NONE){
+      _code = code;
+      _contentType = contentType;
+      _allowedMethods = allowedMethods;
+    }
+    //Response without a body (ie 204 or 304)
+    void send(const char *code){ begin(code, "text/plain"); }
+    //Response whose whole body is already in memory
+    //Its length is known up front so it never needs chunks, if it doesn't fit in the buffer it is sent straight from data
+    void send(const char *code, const char *contentType, const uint8_t *data, size_t len){
+      begin(code, contentType);
+      if(_headerSent || _bodyLen > 0){ return; }
+      _length = len;
+      write(data, len);
+    }
+    void send(const char *code, const char *contentType, const char *data){
+      send(code, contentType, reinterpret_cast<const uint8_t*>(data), strlen(data));
+    }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *data, size_t len) override {
+      if(_code == nullptr){ return 0; } //begin() wasn't called
+      size_t written = 0;
+      while(written < len){
+        size_t room = MAX_BODY_BYTES - _bodyLen;
+        if(room == 0){
+          _flush(false);
+          //A big body with a known end doesn't need to go through the buffer
+          if(!_chunked && len - written >= MAX_BODY_BYTES){
+            _write(data + written, len - written);
+            return len;
+          }
+          continue;
+        }
+        size_t n = len - written < room ? len - written : room;
+        memcpy(_body() + _bodyLen, data + written, n);
+        _bodyLen += n;
+        written += n;
+      }
+      return len;
+    }
+
+    //Client the response goes to, for callbacks that take it over (see WebServer::detachClient)
+    WiFiClient& client(){ return *_client; }
+
+    //Sends whatever is held back
+    //Returns whether the connection can stay open for another request
+    bool finish(){
+      if(_code == nullptr){ return false; } //Nothing to send
+      if(!_headerSent && _length == Net::LENGTH_UNKNOWN){ _length = _bodyless() ? Net::NO_BODY : _bodyLen; } //Whole body is here
+      _flush(true);
+      ++_stats.responses;
+      if(_chunked){ ++_stats.chunked; }
+      return _keepAlive;
+    }
+
+    const Stats& stats() const { return _stats; }
+  private:
+    static const uint8_t CHUNK_LINE_BYTES = 6; //Hex length (up to FFFF) plus "\r\n"
+    static const uint8_t TAIL_BYTES = 7; //"\r\n" after a chunk plus the last chunk "0\r\n\r\n"
+    WiFiClient *_client;
+    bool _keepAlive;
+    bool _chunkedAllowed;
+    const char *_code;
+    const char *_contentType;
+    uint8_t _allowedMethods;
+    bool _headerSent;
+    bool _chunked;
+    int32_t _length; //Content-Length to send, LENGTH_UNKNOWN until it is known
+    //Room for the header and a chunk length line in front of the body and a chunk ending after it
+    //so everything can be put next to each other and sent at once
+    uint8_t _buf[MAX_HEADER_BYTES + CHUNK_LINE_BYTES + MAX_BODY_BYTES + TAIL_BYTES];
+    size_t _bodyLen;
+    const char *_extraNames[MAX_EXTRA_HEADERS];
+    const char *_extraValues[MAX_EXTRA_HEADERS];
+    uint8_t _extraCount;
+    Stats _stats;
+
+    uint8_t* _body(){ return _buf + MAX_HEADER_BYTES + CHUNK_LINE_BYTES; }
+
+    //Whether the status can't have a body (1xx, 204 and 304)
+    bool _bodyless() const {
+      return _code[0] == '1' || strncmp(_code, "204", 3) == 0 || strncmp(_code, "304", 3) == 0;
+    }
+
+    void _write(const uint8_t *data, size_t len){
+      if(len == 0){ return; }
+      _client->write(data, len);
+      ++_stats.writes;
+      _stats.segments += (len + SEGMENT_BYTES - 1) / SEGMENT_BYTES;
+    }
+
+    void _writeHeader(Print &out){
+      Net::writeHeader(out, _code, _length == Net::NO_BODY ? nullptr : _contentType, _allowedMethods);
+      for(uint8_t i = 0; i < _extraCount; ++i){
+        out.print(_extraNames[i]);
+        out.print(": ");
+        out.println(_extraValues[i]);
+      }
+      Net::endHeader(out, _length, _keepAlive, _chunked);
+    }
+
+    //Sends the header (if it wasn't yet) and the buffered body in one write
+    //last is whether the body is complete
+    void _flush(bool last){
+      if(!_headerSent && _length == Net::LENGTH_UNKNOWN){ //The body doesn't fit, its length can't be known
+        if(_chunkedAllowed){ _chunked = true; }
+        else{ _keepAlive = false; }
+      }
+      size_t start = _body() - _buf;
+      size_t end = start + _bodyLen;
+      if(_chunked && _bodyLen > 0){
+        char line[CHUNK_LINE_BYTES + 1];
+        uint8_t n = snprintf(line, sizeof(line), "%X\r\n", static_cast<unsigned>(_bodyLen));
+        start -= n;
+        memcpy(_buf + start, line, n);
+        memcpy(_buf + end, "\r\n", 2);
+        end += 2;
+      }
+      if(_chunked && last){
+        memcpy(_buf + end, "0\r\n\r\n", 5);
+        end += 5;
+      }
+      if(!_headerSent){
+        _headerSent = true;
+        BufferPrint head{reinterpret_cast<char*>(_buf), MAX_HEADER_BYTES};
+        _writeHeader(head);
+        if(head.overflow){ //Shouldn't happen with sane headers, send it on its own
+          ::println("Response header too big for the buffer"); //Util's, not this Print's
+          _writeHeader(*_client);
+          ++_stats.writes;
+        }
+        else{ //Move it right in front of the body
+          memmove(_buf + start - head.len, _buf, head.len);
+          start -= head.len;
+        }
+      }
+      _write(_buf + start, end - start);
+      _bodyLen = 0;
+    }
+};
+#endif //RESPONSE_H
@@ -0,0 +1,136 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef ROUTER_H
+#define ROUTER_H
+#include "Util.h"
+#include "WebPath.h"
+#include "HttpRequest.h"
+//Finds the WebPath for a request path through a trie of every registered path
+//A path either has to match exactly or, with WebPath::PREFIX, only has to start the request path
+//An exact match wins over a prefix one, the longest prefix wins over shorter ones
+//The trie is (re)built the first time a lookup happens after paths were added,
+//so registering everything in setup() only pays for one build
+//Paths and nodes are allocated then and never again while serving
+class Router{
+  public:
+    static const uint16_t NONE = UINT16_MAX;
+    enum class Result : uint8_t{
+      FOUND,
+      BAD_METHOD, //Path exists but doesn't take the method
+      NOT_FOUND
+    };
+    Router():
+      _routes(nullptr),
+      _count(0),
+      _capacity(0),
+      _nodes(nullptr),
+      _nodeCount(0),
+      _built(true)
+    {}
+    ~Router(){
+      delete[] _routes;
+      delete[] _nodes;
+    }
+    Router(const Router&) = delete;
+    Router& operator=(const Router&) = delete;
+
+    //Returns false if the path is already there
+    bool add(const WebPath &path){
+      for(uint16_t i = 0; i < _count; ++i){
+        if(_routes[i].path == path.path){ return false; }
+      }
+      if(_count == _capacity){
+        if(_capacity >= NONE / 2){ return false; }
+        uint16_t capacity = _capacity == 0 ? 8 : _capacity * 2;
+        WebPath *routes = new WebPath[capacity];
+        for(uint16_t i = 0; i < _count; ++i){ routes[i] = _routes[i]; }
+        delete[] _routes;
+        _routes = routes;
+        _capacity = capacity;
+      }
+      _routes[_count++] = path;
+      _built = false;
+      return true;
+    }
+
+    //Finds the path for the request
+    //If ourHost is false (the request was meant for another host) only WebPath::ANY_HOST paths are considered
+    //route is set to the path when it is found or doesn't take the method, nullptr otherwise
+    Result find(const StrView &path, WebPath::method_t method, bool ourHost, const WebPath *&route){
+      route = nullptr;
+      if(!_built){ _build(); }
+      if(_nodeCount == 0){ return Result::NOT_FOUND; }
+      uint16_t best = _usable(_nodes[0].prefix, ourHost) ? _nodes[0].prefix : NONE;
+      uint16_t node = 0;
+      uint16_t i = 0;
+      for(; i < path.len; ++i){
+        node = _child(node, path.data[i]);
+        if(node == NONE){ break; }
+        if(_usable(_nodes[node].prefix, ourHost)){ best = _nodes[node].prefix; }
+      }
+      if(i == path.len && _usable(_nodes[node].exact, ourHost)){ best = _nodes[node].exact; }
+      if(best == NONE){ return Result::NOT_FOUND; }
+      route = &_routes[best];
+      return (route->methods & method) == 0 ? Result::BAD_METHOD : Result::FOUND;
+    }
+
+    uint16_t count() const { return _count; }
+  private:
+    //Siblings are linked so a node only takes one entry no matter how many children it has
+    struct Node{
+      char c;
+      uint16_t child; //First child
+      uint16_t sibling; //Next child of the same parent
+      uint16_t exact; //Route that ends here
+      uint16_t prefix; //Prefix route that ends here
+    };
+    WebPath *_routes;
+    uint16_t _count;
+    uint16_t _capacity;
+    Node *_nodes;
+    uint16_t _nodeCount;
+    bool _built; //Whether the trie is up to date with the routes
+
+    bool _usable(uint16_t route, bool ourHost) const {
+      return route != NONE && (ourHost || (_routes[route].flags & WebPath::ANY_HOST));
+    }
+
+    uint16_t _child(uint16_t node, char c) const {
+      for(uint16_t n = _nodes[node].child; n != NONE; n = _nodes[n].sibling){
+        if(_nodes[n].c == c){ return n; }
+      }
+      return NONE;
+    }
+
+    void _build(){
+      _built = true;
+      delete[] _nodes;
+      _nodes = nullptr;
+      _nodeCount = 0;
+      //Worst case every char of every path is its own node
+      uint32_t maxNodes = 1;
+      for(uint16_t i = 0; i < _count; ++i){ maxNodes += _routes[i].path.length(); }
+      if(maxNodes >= NONE){
+        println("Too many web paths for the router");
+        return;
+      }
+      _nodes = new Node[maxNodes];
+      _nodes[_nodeCount++] = {'\0', NONE, NONE, NONE, NONE};
+      for(uint16_t i = 0; i < _count; ++i){
+        const String &path = _routes[i].path;
+        uint16_t node = 0;
+        for(uint16_t j = 0; j < path.length(); ++j){
+          uint16_t next = _child(node, path[j]);
+          if(next == NONE){
+            next = _nodeCount++;
+            _nodes[next] = {path[j], NONE, _nodes[node].child, NONE, NONE};
+            _nodes[node].child = next;
+          }
+          node = next;
+        }
+        if(_routes[i].flags & WebPath::PREFIX){ _nodes[node].prefix = i; }
+        else{ _nodes[node].exact = i; }
+      }
+    }
+};
+#endif //ROUTER_H
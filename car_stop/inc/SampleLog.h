@@ -0,0 +1,170 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef SAMPLE_LOG_H
+#define SAMPLE_LOG_H
+#include <stdint.h>
+#include <string.h>
+#include "Time.h"
+//Compressed (time, value) samples in fixed size blocks that can be decoded on their own
+//Block layout
+//  count (1 byte), varint(first time), varint(zigzag(first value))
+//  then for every other sample
+//    varint(zigzag(value delta) << TIME_BITS | time code)
+//    time code is the change in interval from the last one (delta of delta) plus TIME_BIAS when that fits,
+//    TIME_ESCAPE if it doesn't and then varint(zigzag(interval - last interval)) follows
+//A sensor reading at a steady rate with a slowly moving value costs 1-2 bytes per sample instead of 12,
+//jitter of a few ms in when readings are picked up usually still fits the first byte
+namespace SampleBlock{
+  const uint8_t MAX_HEADER_BYTES = 1 + 10 + 5; //Count, 64 bit varint, 32 bit varint
+  const uint8_t MAX_COUNT = UINT8_MAX;
+  const uint8_t MAX_ENCODED_BYTES = 20; //Two 10 byte varints
+  const uint8_t TIME_BITS = 3; //Interval changes of -3 to 3 ms
+  const uint8_t TIME_ESCAPE = (1 << TIME_BITS) - 1;
+  const int8_t TIME_BIAS = TIME_ESCAPE / 2;
+
+  inline uint64_t zigzag(int64_t v){ return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+  inline int64_t unzigzag(uint64_t v){ return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+  //Writes v as a LEB128 varint, returns the number of bytes written
+  inline uint8_t putVarint(uint8_t *out, uint64_t v){
+    uint8_t len = 0;
+    while(v >= 0x80){
+      out[len++] = static_cast<uint8_t>(v) | 0x80;
+      v >>= 7;
+    }
+    out[len++] = static_cast<uint8_t>(v);
+    return len;
+  }
+
+  //Reads a varint from data[idx] and moves idx past it
+  //Returns false if it runs past size
+  inline bool getVarint(const uint8_t *data, size_t size, size_t &idx, uint64_t &v){
+    v = 0;
+    for(uint8_t shift = 0; shift < 64 && idx < size; shift += 7){
+      uint8_t b = data[idx++];
+      v |= static_cast<uint64_t>(b & 0x7F) << shift;
+      if((b & 0x80) == 0){ return true; }
+    }
+    return false;
+  }
+
+  //Starts a block with its first sample, returns the header's length
+  inline uint8_t writeHeader(uint8_t *block, Time::Time_t time, int32_t value){
+    block[0] = 1;
+    uint8_t len = 1 + putVarint(block + 1, time);
+    return len + putVarint(block + len, zigzag(value));
+  }
+
+  inline uint8_t count(const uint8_t *block){ return block[0]; }
+
+  //Reads the header of a block that has at least one sample, idx is set to where the next sample starts
+  //Returns false if it runs past size
+  inline bool readHeader(const uint8_t *block, size_t size, Time::Time_t &time, int32_t &value, size_t &idx){
+    uint64_t v;
+    idx = 1;
+    if(!getVarint(block, size, idx, time) || !getVarint(block, size, idx, v)){ return false; }
+    value = static_cast<int32_t>(unzigzag(v));
+    return true;
+  }
+
+  inline Time::Time_t firstTime(const uint8_t *block, size_t size){
+    Time::Time_t time = 0;
+    int32_t value;
+    size_t idx;
+    readHeader(block, size, time, value, idx);
+    return time;
+  }
+
+  //Calls fn(time, value) for every sample in the block, oldest first
+  //Returns false if the block is corrupt
+  template<typename F>
+  bool decode(const uint8_t *block, size_t size, F fn){
+    if(size == 0 || count(block) == 0){ return true; }
+    Time::Time_t time;
+    int32_t first;
+    size_t idx;
+    if(!readHeader(block, size, time, first, idx)){ return false; }
+    uint32_t value = static_cast<uint32_t>(first);
+    int64_t interval = 0;
+    fn(time, first);
+    for(uint8_t i = 1; i < count(block); ++i){
+      uint64_t head = 0, change = 0;
+      if(!getVarint(block, size, idx, head)){ return false; }
+      uint8_t code = head & TIME_ESCAPE;
+      if(code == TIME_ESCAPE){
+        if(!getVarint(block, size, idx, change)){ return false; }
+        interval += unzigzag(change);
+      }
+      else{ interval += code - TIME_BIAS; }
+      time += interval;
+      value += static_cast<uint32_t>(unzigzag(head >> TIME_BITS));
+      fn(time, static_cast<int32_t>(value));
+    }
+    return true;
+  }
+};
+
+//Ring of BLOCKS compressed blocks of BLOCK_BYTES each
+//When every block is full the oldest one is cleared and reused
+template<uint16_t BLOCKS, uint16_t BLOCK_BYTES>
+class SampleLog{
+  static_assert(BLOCK_BYTES >= SampleBlock::MAX_HEADER_BYTES, "A block has to fit its first sample");
+  public:
+    static const size_t BYTES = BLOCKS * BLOCK_BYTES;
+    SampleLog() : _cur(0), _filled(0), _used(0), _lastTime(0), _lastValue(0), _lastInterval(0){}
+
+    void append(Time::Time_t time, int32_t value){
+      if(_filled > 0){
+        uint8_t *block = _blocks[_cur];
+        int64_t interval = static_cast<int64_t>(time - _lastTime);
+        int64_t change = interval - _lastInterval;
+        uint8_t encoded[SampleBlock::MAX_ENCODED_BYTES];
+        bool fits = change >= -SampleBlock::TIME_BIAS && change < SampleBlock::TIME_ESCAPE - SampleBlock::TIME_BIAS;
+        uint8_t code = fits ? static_cast<uint8_t>(change + SampleBlock::TIME_BIAS) : SampleBlock::TIME_ESCAPE;
+        uint64_t head = SampleBlock::zigzag(static_cast<int64_t>(value) - _lastValue) << SampleBlock::TIME_BITS | code;
+        uint8_t len = SampleBlock::putVarint(encoded, head);
+        if(!fits){ len += SampleBlock::putVarint(encoded + len, SampleBlock::zigzag(change)); }
+        if(SampleBlock::count(block) < SampleBlock::MAX_COUNT && _used + len <= BLOCK_BYTES){
+          memcpy(block + _used, encoded, len);
+          _used += len;
+          ++block[0];
+          _lastTime = time;
+          _lastValue = value;
+          _lastInterval = interval;
+          return;
+        }
+        _cur = (_cur + 1) % BLOCKS; //Block is full, start the next one
+      }
+      if(_filled < BLOCKS){ ++_filled; }
+      _used = SampleBlock::writeHeader(_blocks[_cur], time, value);
+      _lastTime = time;
+      _lastValue = value;
+      _lastInterval = 0;
+    }
+
+    //Calls fn(time, value) for every sample at or after from, oldest first
+    template<typename F>
+    void forEach(Time::Time_t from, F fn) const {
+      uint16_t oldest = _filled < BLOCKS ? 0 : (_cur + 1) % BLOCKS;
+      for(uint16_t i = 0; i < _filled; ++i){
+        uint16_t idx = (oldest + i) % BLOCKS;
+        //Skip blocks that end before from (the next block starts before it)
+        if(i + 1 < _filled && SampleBlock::firstTime(_blocks[(idx + 1) % BLOCKS], BLOCK_BYTES) <= from){ continue; }
+        SampleBlock::decode(_blocks[idx], idx == _cur ? _used : BLOCK_BYTES, [&](Time::Time_t time, int32_t value){
+          if(time >= from){ fn(time, value); }
+        });
+      }
+    }
+    //Blocks holding samples
+    uint16_t blocksUsed() const { return _filled; }
+  private:
+    uint8_t _blocks[BLOCKS][BLOCK_BYTES];
+    uint16_t _cur; //Block being appended to
+    uint16_t _filled; //Blocks in use
+    uint16_t _used; //Bytes used in the current block
+    //Last sample appended, needed to encode the next one
+    Time::Time_t _lastTime;
+    int32_t _lastValue;
+    int64_t _lastInterval;
+};
+#endif //SAMPLE_LOG_H
@@ -0,0 +1,194 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef SETTING_STORE_H
+#define SETTING_STORE_H
+#include <Preferences.h>
+#include "DataPointManager.h"
+//Keeps every persistent data point (see DataPoint::persistent) in a single Preferences (NVS flash) entry
+//Blob layout
+//  version (1 byte), count (1 byte)
+//  for each data point: name length (1 byte), name, value length (1 byte), value (see DataPoint::toBytes)
+//  CRC-32 of everything before it (4 bytes, little endian)
+//Data points are matched by name so adding or removing one doesn't invalidate the rest
+//A change (noticed through the sequence numbers) marks the store dirty,
+//it is written once nothing changed for debounce ms, or maxDelay ms after the first change if changes keep coming
+//The blob is only written if it differs from what is in flash
+//Writes and the time they take are counted to keep an eye on flash wear and loop stalls
+template<uint16_t MAX_POINTS>
+class SettingStore{
+  public:
+    static const uint8_t VERSION = 1;
+    static const size_t MAX_BYTES = 256;
+    struct Stats{
+      uint32_t writes = 0; //Blobs written to flash
+      uint32_t skipped = 0; //Blobs that were already in flash
+      uint32_t writeTime = 0; //Total us spent writing
+      uint32_t maxWriteTime = 0; //Longest write in us
+    };
+    //key has to stay valid (ie a string literal)
+    SettingStore(Preferences &prefs, const char *key, Time::Time_t debounce, Time::Time_t maxDelay):
+      _prefs(prefs),
+      _key(key),
+      _debounce(debounce),
+      _maxDelay(maxDelay),
+      _dps(nullptr),
+      _seenSeq(0),
+      _dirty(false),
+      _firstChange(0),
+      _lastChange(0),
+      _storedLen(0)
+    {}
+
+    //Restores every persistent data point in dps from flash in one pass, call once after adding them
+    //Values go through the data points' set functions, bad ones are skipped
+    //Returns false if there is no valid blob (nothing is restored then)
+    bool load(DataPointManager<MAX_POINTS> &dps){
+      _dps = &dps;
+      bool valid = _read();
+      if(valid){
+        uint8_t count = _stored[1];
+        size_t idx = 2;
+        for(uint8_t i = 0; i < count; ++i){
+          const char *name = reinterpret_cast<const char*>(_stored + idx + 1);
+          uint8_t nameLen = _stored[idx];
+          uint8_t valueLen = _stored[idx + 1 + nameLen];
+          const uint8_t *value = _stored + idx + 2 + nameLen;
+          idx += 2 + nameLen + valueLen;
+          DataPoint *dp = dps.find(name, nameLen);
+          if(dp == nullptr || !dp->persistent){ continue; }
+          if(dp->setValueBytes(value, valueLen) == DataPoint::BAD){
+            print("Bad stored value for ");
+            println(dp->name);
+          }
+        }
+      }
+      else{ _storedLen = 0; }
+      _seenSeq = DataPoint::curSeq();
+      _dirty = false;
+      return valid;
+    }
+
+    //Has the store written with the next batch even if nothing was stamped
+    void markDirty(){
+      _storedLen = 0; //Make sure it isn't skipped
+      _markDirty(Time::now(false).raw);
+    }
+
+    //Notices changes and writes them once due, call once per loop after DataPointManager::sync()
+    void poll(){
+      if(_dps == nullptr){ return; }
+      Time::Time_t now = Time::now(false).raw;
+      if(DataPoint::curSeq() != _seenSeq){ //Something changed, see if it was persistent
+        for(uint16_t i = 0; i < _dps->count(); ++i){
+          const DataPoint &dp {_dps->get(i)};
+          if(dp.persistent && dp.changedSince(_seenSeq)){
+            _markDirty(now);
+            break;
+          }
+        }
+        _seenSeq = DataPoint::curSeq();
+      }
+      if(_dirty && (now - _lastChange >= _debounce || now - _firstChange >= _maxDelay)){ flush(); }
+    }
+
+    //Writes the blob now if anything changed (ie before restarting)
+    void flush(){
+      _dirty = false;
+      if(_dps == nullptr){ return; }
+      uint32_t start = micros();
+      uint8_t blob[MAX_BYTES];
+      size_t len = _build(blob);
+      if(len == _storedLen && memcmp(blob, _stored, len) == 0){
+        ++_stats.skipped;
+        return;
+      }
+      if(_prefs.putBytes(_key, blob, len) != len){
+        println("Error writing settings");
+        return;
+      }
+      memcpy(_stored, blob, len);
+      _storedLen = len;
+      ++_stats.writes;
+      uint32_t elapsed = micros() - start;
+      _stats.writeTime += elapsed;
+      if(elapsed > _stats.maxWriteTime){ _stats.maxWriteTime = elapsed; }
+    }
+
+    bool dirty() const { return _dirty; }
+    const Stats& stats() const { return _stats; }
+  private:
+    static const uint8_t CRC_BYTES = 4;
+    Preferences &_prefs;
+    const char *_key;
+    Time::Time_t _debounce;
+    Time::Time_t _maxDelay;
+    DataPointManager<MAX_POINTS> *_dps;
+    DataPoint::seq_t _seenSeq; //Sequence number as of the last check for changes
+    bool _dirty;
+    Time::Time_t _firstChange; //First change since the last write
+    Time::Time_t _lastChange;
+    uint8_t _stored[MAX_BYTES]; //Blob that is in flash
+    size_t _storedLen;
+    Stats _stats;
+
+    //Reads the blob into _stored
+    //Returns whether it is there and valid
+    bool _read(){
+      size_t len = _prefs.getBytesLength(_key);
+      if(len < 2 + CRC_BYTES || len > MAX_BYTES || _prefs.getBytes(_key, _stored, len) != len){ return false; }
+      _storedLen = len;
+      len -= CRC_BYTES;
+      uint32_t crc = 0;
+      for(uint8_t i = 0; i < CRC_BYTES; ++i){ crc |= static_cast<uint32_t>(_stored[len + i]) << (i * 8); }
+      if(crc != crc32(_stored, len) || _stored[0] != VERSION){
+        println("Stored settings are corrupt or from another version");
+        return false;
+      }
+      //Make sure every entry is inside the blob so load() doesn't have to check
+      size_t idx = 2;
+      for(uint8_t i = 0; i < _stored[1]; ++i){
+        if(idx + 1 > len || idx + 2 + _stored[idx] > len){ return false; }
+        idx += 2 + _stored[idx] + _stored[idx + 1 + _stored[idx]];
+      }
+      return idx == len;
+    }
+
+    //Writes every persistent data point into blob
+    //Returns the length of the blob
+    size_t _build(uint8_t *blob){
+      uint8_t count = 0;
+      size_t len = 2;
+      for(uint16_t i = 0; i < _dps->count(); ++i){
+        const DataPoint &dp {_dps->get(i)};
+        if(!dp.persistent){ continue; }
+        uint8_t value[DataPoint::MAX_BYTES];
+        size_t valueLen = dp.toBytes(value, sizeof(value));
+        if(len + 2 + dp.nameLen + valueLen + CRC_BYTES > MAX_BYTES || count == UINT8_MAX){
+          print("No room to store ");
+          println(dp.name);
+          continue;
+        }
+        blob[len++] = dp.nameLen;
+        memcpy(blob + len, dp.name, dp.nameLen);
+        len += dp.nameLen;
+        blob[len++] = valueLen;
+        memcpy(blob + len, value, valueLen);
+        len += valueLen;
+        ++count;
+      }
+      blob[0] = VERSION;
+      blob[1] = count;
+      uint32_t crc = crc32(blob, len);
+      for(uint8_t i = 0; i < CRC_BYTES; ++i){ blob[len++] = static_cast<uint8_t>(crc >> (i * 8)); }
+      return len;
+    }
+
+    void _markDirty(Time::Time_t now){
+      if(!_dirty){
+        _dirty = true;
+        _firstChange = now;
+      }
+      _lastChange = now;
+    }
+};
+#endif //SETTING_STORE_H
@@ -0,0 +1,40 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef STATIC_ASSET_H
+#define STATIC_ASSET_H
+#include "Response.h"
+#include "HttpRequest.h"
+//File built into the firmware (see gz.sh), served gzipped to clients that take it
+//and answered with 304 when the client already has it (If-None-Match matches the ETag of the copy it would get)
+//The WebServer has to collect "Accept-Encoding" and "If-None-Match" for that to work
+struct StaticAsset{
+  const char *contentType;
+  const char *cacheControl;
+  const char *plain;
+  const uint8_t *gzip; //nullptr if there isn't a compressed copy
+  size_t gzipLen;
+  const char *etag; //Quoted hash of the content, nullptr to not use one
+  const char *gzipEtag; //etag of the compressed copy, a different body needs a different strong ETag
+
+  void send(Response &res, const HttpRequest &req) const {
+    res.header("Cache-Control", cacheControl);
+    if(gzip != nullptr){ res.header("Vary", "Accept-Encoding"); }
+    bool gzipped = gzip != nullptr && req.header("Accept-Encoding").contains("gzip");
+    const char *tag = gzipped ? gzipEtag : etag;
+    if(tag != nullptr){
+      res.header("ETag", tag);
+      StrView match {req.header("If-None-Match")};
+      if(match.equals("*") || match.contains(tag)){
+        res.send(Net::HTTP_RES_NOT_MODIFIED);
+        return;
+      }
+    }
+    if(gzipped){
+      res.header("Content-Encoding", "gzip");
+      res.send(Net::HTTP_RES_OK, contentType, gzip, gzipLen);
+      return;
+    }
+    res.send(Net::HTTP_RES_OK, contentType, plain);
+  }
+};
+#endif //STATIC_ASSET_H
@@ -8,6 +8,8 @@ class TOFSensor{
   public:
     using DistanceMode = VL53L1X::DistanceMode;
     using distance_t = uint16_t;
+    //Called with every reading taken
+    using sample_fn_t = void (*)(distance_t);
     //0, 0 is top left
     struct Coord{
       uint8_t x, y;
@@ -21,7 +23,8 @@ class TOFSensor{
       _roiCenter(roiCenter),
       _readingCount(readingCount),
       _readingIdx(0),
-      _initErr(true)
+      _initErr(true),
+      _onSample(nullptr)
     {
       _readings = new distance_t[_readingCount];
       memset(_readings, 0, sizeof(_readings) / sizeof(_readings[0]));
@@ -67,9 +70,13 @@ class TOFSensor{
       distance_t reading = _sensor.read(blocking);
       _readings[_readingIdx] = reading;
       _readingIdx = (_readingIdx + 1) % _readingCount;
+      if(_onSample != nullptr){ _onSample(reading); }
       return reading;
     }
 
+    //Sets the function that records every reading (nullptr to stop)
+    void onSample(sample_fn_t fn){ _onSample = fn; }
+
     bool dataReady() { return _sensor.dataReady(); }
 
     bool initErr() const { return _initErr; }
@@ -107,5 +114,6 @@ class TOFSensor{
     distance_t* _readings;
     uint8_t _readingIdx;
     const uint8_t _readingCount;
+    sample_fn_t _onSample;
 };
 #endif //TOF_SENSOR_H
\ No newline at end of file
@@ -2,6 +2,7 @@
 //All Rights Reserved
 #ifndef TIME_H
 #define TIME_H
+#include "Util.h"
 //64 bit time
 struct Time{
     using Time_t = uint64_t;
@@ -118,40 +119,34 @@ struct Time{
             _curTime.raw += time32; //Add current lower 32 bits
         }
     }
-    //Converts te time to a human readable format (dd:hh:mm:SS.sss)
-    static String toString(Time_t t){
-        String out{};
-        out.reserve(15);
-        Time_t ms[4] = {MS_IN_DAY, MS_IN_HOUR, MS_IN_MIN, MS_IN_SEC};
-        String cStr {};
-        cStr.reserve(3);
+    //Writes the time in a human readable format (dd:hh:mm:SS.sss) to buf
+    //Leading units that are 0 are left out
+    //Returns the length of the full string, which can be more than size (output is cut off then)
+    static size_t toChars(Time_t t, char *buf, size_t size){
+        const Time_t ms[4] = {MS_IN_DAY, MS_IN_HOUR, MS_IN_MIN, MS_IN_SEC};
+        size_t len = 0;
+        bool started = false;
         for(uint8_t i = 0; i < 4; ++i){
             Time_t count = t / ms[i];
-            if(count || out.length()){
-                cStr = String(count);
-                if(cStr.length() < 2 && out.length()){ //Add leading 0 if value is less than 10 and its not the first value
-                    out += '0';
-                }
-                out += cStr;
-                out += ':';
+            if(count || started){
+                //Add leading 0 if value is less than 10 and its not the first value
+                len += snprintf(buf + len, len < size ? size - len : 0, started ? ":%02llu" : "%llu", static_cast<unsigned long long>(count));
+                started = true;
                 t -= count * ms[i];
             }
         }
-        if(out.length()){
-            out.setCharAt(out.length()-1, '.');
-        }
-        else{
-            out = "0.";
-        }
-        cStr = String(t);
-        if(cStr.length() == 1 && t){
-            cStr += "00";
+        if(!started){
+            len += snprintf(buf + len, len < size ? size - len : 0, "0");
         }
-        else if(cStr.length() == 2){
-            cStr += '0';
-        }
-        out += cStr;
-        return out;
+        len += snprintf(buf + len, len < size ? size - len : 0, ".%03u", static_cast<unsigned>(t));
+        return len;
+    }
+
+    //Converts te time to a human readable format (dd:hh:mm:SS.sss)
+    static String toString(Time_t t){
+        char buf[32];
+        toChars(t, buf, sizeof(buf));
+        return String(buf);
     }
 
     //Converts te time to a human readable format (dd:hh:mm:SS.sss)
@@ -0,0 +1,124 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef TOP_NAMES_H
+#define TOP_NAMES_H
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include "JsonWriter.h"
+//Most often seen DNS names (wire format), counted with the space-saving algorithm in N counters
+//A name that isn't counted takes over the counter with the lowest count and starts from it, so a count
+//is at most error too high, any name seen more than total / N times is in the table
+//Names are told apart by length and hash, only their first NAME_BYTES are kept to show
+//add() is called from one task (AsyncUDP's) while writeJSON() can be called from another (loop()), writeJSON()
+//works on a copy made while add() wasn't running
+template<uint8_t N, uint8_t NAME_BYTES>
+class TopNames{
+  public:
+    struct Counter{
+      uint32_t hash;
+      uint32_t count = 0; //0 if unused
+      uint32_t error;
+      uint16_t length; //Of the whole name
+      uint8_t name[NAME_BYTES];
+    };
+
+    void add(const uint8_t *name, uint16_t length){
+      uint32_t hash = HASH_SEED;
+      uint16_t pos = 0;
+      for(; pos + 4 <= length; pos += 4){ //| 0x20 folds case (and some other bytes, it is only a hash)
+        uint32_t word;
+        memcpy(&word, name + pos, 4);
+        hash = (hash ^ (word | 0x20202020u)) * HASH_PRIME;
+      }
+      for(; pos < length; ++pos){ hash = (hash ^ (name[pos] | 0x20u)) * HASH_PRIME; }
+      Counter *min = &_counters[0];
+      for(uint8_t i = 0; i < N; ++i){
+        Counter &c = _counters[i];
+        if(c.count > 0 && c.hash == hash && c.length == length){
+          _beginWrite();
+          ++c.count;
+          _endWrite();
+          return;
+        }
+        if(c.count < min->count){ min = &c; }
+      }
+      _beginWrite();
+      min->hash = hash;
+      min->error = min->count;
+      ++min->count;
+      min->length = length;
+      uint16_t kept = length < NAME_BYTES ? length : NAME_BYTES;
+      for(uint16_t i = 0; i < kept; ++i){ min->name[i] = _lower(name[i]); }
+      _endWrite();
+    }
+
+    //Array of {"name", "count", "error"} from the most seen
+    void writeJSON(JsonWriter &json) const {
+      Counter counters[N];
+      _copy(counters);
+      bool written[N] = {};
+      json.beginArray();
+      for(uint8_t n = 0; n < N; ++n){
+        int16_t top = -1;
+        for(uint8_t i = 0; i < N; ++i){
+          if(!written[i] && counters[i].count > 0 && (top < 0 || counters[i].count > counters[top].count)){ top = i; }
+        }
+        if(top < 0){ break; }
+        written[top] = true;
+        const Counter &c = counters[top];
+        char name[NAME_BYTES];
+        json.beginObject();
+        json.key("name");
+        json.value(name, _toText(c, name));
+        json.key("count");
+        json.value(c.count);
+        json.key("error");
+        json.value(c.error);
+        json.endObject();
+      }
+      json.endArray();
+    }
+  private:
+    static const uint32_t HASH_SEED = 2166136261u;
+    static const uint32_t HASH_PRIME = 16777619u;
+    static const uint8_t MAX_COPY_TRIES = 8;
+    Counter _counters[N];
+    std::atomic<uint32_t> _version{0};
+
+    static uint8_t _lower(uint8_t c){ return c >= 'A' && c <= 'Z' ? c | 0x20 : c; }
+
+    //_version is odd while a counter changes, add() is the only writer so it doesn't need a locked add
+    void _beginWrite(){
+      _version.store(_version.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+    }
+    void _endWrite(){ _version.store(_version.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    //Copies the counters, tries again if add() changed them meanwhile
+    //Gives up on a consistent copy after MAX_COPY_TRIES, a count may be off by one then
+    void _copy(Counter *out) const {
+      for(uint8_t tries = 0; tries < MAX_COPY_TRIES; ++tries){
+        uint32_t before = _version.load(std::memory_order_acquire);
+        memcpy(out, _counters, sizeof(_counters));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(before % 2 == 0 && _version.load(std::memory_order_relaxed) == before){ return; }
+      }
+    }
+    //Writes c's name with dots (no root), returns its length
+    //A label cut off by NAME_BYTES (or torn by a copy that gave up) ends the name there
+    static uint8_t _toText(const Counter &c, char *out){
+      uint8_t kept = c.length < NAME_BYTES ? c.length : NAME_BYTES;
+      uint8_t len = 0;
+      for(uint8_t pos = 0; pos < kept && c.name[pos] != 0;){
+        uint8_t labelLength = c.name[pos];
+        if(pos + 1 + labelLength > kept){ break; }
+        if(len > 0){ out[len++] = '.'; }
+        memcpy(out + len, c.name + pos + 1, labelLength);
+        len += labelLength;
+        pos += labelLength + 1;
+      }
+      return len;
+    }
+};
+#endif //TOP_NAMES_H
@@ -2,6 +2,7 @@
 //All Rights Reserved
 #ifndef UTIL_H
 #define UTIL_H
+#include <Arduino.h>
 
 #ifndef ENABLE_SERIAL
 #define ENABLE_SERIAL true
@@ -102,20 +103,17 @@ int64_t toInt(const String &s){
   }
 }
 
-//Represents a URI encoded character
-struct EncodedChar{
-  const char *code;
-  char c;
-  EncodedChar(const char *code, char c) : code(code), c(c){}
-};
-const EncodedChar ENCODED_CHARS[] = {{"%20", ' '}, {"%21", '!'}, {"%22", '"'}, {"%23", '#'}, {"%24", '$'}, {"%25", '%'}, {"%26", '&'}, {"%27", '\''}, {"%28", '('}, {"%29", ')'}, {"%2A", '*'}, {"%2B", '+'}, {"%2C", ','}, {"%2D", '-'}, {"%2E", '.'}, {"%2F", '/'}, {"%3A", ':'}, {"%3B", ';'}, {"%3C", '<'}, {"%3D", '='}, {"%3E", '>'}, {"%3F", '?'}, {"%40", '@'}, {"%5B", '['}, {"%5C", '\\'}, {"%5D", ']'}, {"%5E", '^'}, {"%5F", '_'}, {"%60", '`'}, {"%7B", '{'}, {"%7C", '|'}, {"%7D", '}'}, {"%7E", '~'}};
-const uint8_t ENCODED_CHAR_COUNT = sizeof(ENCODED_CHARS) / sizeof(EncodedChar);
-
-//Replaces URI encoded chars in the string with their actual char representation
-void replaceURIEncodedChars(String &str){
-  for(uint8_t i = 0; i < ENCODED_CHAR_COUNT; ++i){
-    str.replace(ENCODED_CHARS[i].code, String(ENCODED_CHARS[i].c));
+//CRC-32 (IEEE, same as zlib) of data
+//Pass the result of a previous call as crc to continue it over more data
+uint32_t crc32(const uint8_t *data, size_t len, uint32_t crc = 0){
+  crc = ~crc;
+  for(size_t i = 0; i < len; ++i){
+    crc ^= data[i];
+    for(uint8_t bit = 0; bit < 8; ++bit){
+      crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
   }
+  return ~crc;
 }
 
 //Essentially exit(), but it doesn't reboot
@@ -4,27 +4,36 @@
 #define WEB_PATH_H
 #include <WiFi.h>
 #include <stdint.h>
+class HttpRequest;
+class Response;
 //Represents a path for the web server
 struct WebPath{
   using method_t = uint8_t;
-  //static void dummyCallback(WiFiClient&, method_t, const String&){}
   static const method_t NONE = 0;
   static const method_t GET = 1;
   static const method_t POST = 2;
+  using flags_t = uint8_t;
+  static const flags_t EXACT = 0;
+  static const flags_t PREFIX = 1; //Also serves every path starting with path
+  static const flags_t ANY_HOST = 2; //Also served when the request was meant for another host (ie captive portal probes)
   String path;
   //The func thats called when a req is made ot the path
-  //Takes the client, method, and the variable string (everything after '?')
-  void (*callback)(WiFiClient&, method_t, const String&);
+  //Takes the response to write into and the parsed request (method, query parameters, headers)
+  using callback_t = void (*)(Response&, const HttpRequest&);
+  callback_t callback;
   method_t methods; //Supported methods
-  WebPath(String path, void (*callback)(WiFiClient&, method_t, const String&), method_t methods): 
+  flags_t flags;
+  WebPath(String path, callback_t callback, method_t methods, flags_t flags = EXACT): 
     path(path), 
     callback(callback), 
-    methods(methods)
+    methods(methods),
+    flags(flags)
   {}
   WebPath(): 
     path(), 
     callback(nullptr), 
-    methods(NONE)
+    methods(NONE),
+    flags(EXACT)
   {}
 };
 #endif //WEB_PATH_H
\ No newline at end of file
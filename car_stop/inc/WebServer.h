@@ -3,161 +3,365 @@
 #ifndef WEBSERVER_H
 #define WEBSERVER_H
 #include "Networking.h"
+#include "HttpRequest.h"
+#include "Router.h"
+#include "Response.h"
+#include "BufferPrint.h"
+#include "RateLimiter.h"
+#include "WebSocket.h"
+//Serves WebPaths over HTTP without blocking the loop
+//Up to MAX_CONNECTIONS clients are handled at once, each in its own slot that parses the request
+//incrementally from whatever bytes have arrived (see HttpRequest), so a slow or silent client doesn't hold up the rest
+//Connections are kept open between requests (HTTP/1.1 keep-alive) when the response length is known,
+//requests sent back to back on one connection (pipelining) are answered in order
+//Each client IP gets a token bucket (see setRateLimit), a request over it gets a canned 429 before it is parsed
+//Handling stops for the tick once the time budget (see setTimeBudget) is used up, the rest carries on next tick
+//Both are off until they are set
 class WebServer{
   public:
-    static const uint MAX_PATHS{8};
+    static const uint8_t MAX_HEADERS{HttpRequest::MAX_HEADERS};
+    static const uint8_t MAX_CONNECTIONS{4};
+    static const Time::Time_t REQUEST_TIMEOUT{3000}; //ms a client has to send a full request
+    static const Time::Time_t KEEP_ALIVE_TIMEOUT{5000}; //ms a kept connection can sit idle between requests
+    static const uint16_t MAX_KEEP_ALIVE_REQUESTS{32}; //Requests served on a connection before it is closed anyway
+    static const uint8_t MAX_CLIENT_IPS{8}; //Clients tracked by the rate limiter
+    struct Stats{
+      uint32_t connections = 0; //Connections accepted
+      uint32_t requests = 0; //Requests served
+      uint32_t reused = 0; //Requests served on a connection that already had one
+      uint32_t limited = 0; //Requests answered with 429
+      uint32_t deferred = 0; //Ticks that ran out of time before every connection was handled
+    };
     WebServer(uint16_t port, const String& host = String()):
       _port(port),
       _server(port),
-      _host(host)
-    {}
+      _host(host),
+      _headerCount(0),
+      _detached(false),
+      _limiter(0, 0),
+      _timeBudget(0),
+      _tickStart(0),
+      _nextConn(0)
+    {
+      //Needed for acceptWebSocket
+      collectHeader("Upgrade");
+      collectHeader("Sec-WebSocket-Key");
+      //Needed for keep-alive
+      collectHeader("Connection");
+      collectHeader("Content-Length");
+      collectHeader("Transfer-Encoding");
+      //Needed for StaticAsset
+      collectHeader("Accept-Encoding");
+      collectHeader("If-None-Match");
+      //Trick devices into thinking they have internet
+      const WebPath::method_t ANY = WebPath::GET | WebPath::POST;
+      addPath({"/generate_204",        _probeGoogle,    ANY, WebPath::ANY_HOST});
+      addPath({"/hotspot-detect.html", _probeApple,     ANY, WebPath::ANY_HOST});
+      addPath({"/test/success.html",   _probeApple,     ANY, WebPath::ANY_HOST});
+      addPath({"/connecttest.txt",     _probeMicrosoft, ANY, WebPath::ANY_HOST});
+      addPath({"/success.txt",         _probeSuccess,   ANY, WebPath::ANY_HOST});
+      addPath({"/canonical.html",      _probeMozilla,   ANY, WebPath::ANY_HOST});
+    }
     void begin(){
       _server.begin();
     }
-    bool addPath(const WebPath &path){
-      if(_pathExists(path.path) || _pathCount == MAX_PATHS){ return false; }
-      _paths[_pathCount++] = path;
-      return true;
-    }
+    //Returns false if the path is already there
+    bool addPath(const WebPath &path){ return _router.add(path); }
+    //Accepts waiting clients and moves every open connection along as far as the data that arrived allows
+    //Never waits for a client, call once per loop
     void processReq(){
-      if(!_server.hasClient()){ return; }
-      WiFiClient client{_server.accept()};
-      if(!client.connected() || !client.available()){
-        Net::endClient(client);
-        return;
-      }
-      print("New connection: ");
-      print(client.remoteIP().toString());
-      print(':');
-      print(client.remotePort());
-      print('\n');
-      uint8_t clientMethod = WebPath::NONE;
-      //Read to the end of the uri
-      //Doesn't use body to make hanlding variables simpler
-      String req{};
-      if(Net::bufReadStringUntil(client, req, '\n', Net::MAX_REQ_BYTES) == 0){ //URI was oversize
-        Net::sendHeader(client, Net::HTTP_RES_URI_LEN, "text/plain");
-        client.println(Net::HTTP_RES_URI_LEN);
-        println("oversize");
-      }
-      else{
-        //Find method
-        if(req.indexOf("GET") == 0){
-          clientMethod = WebPath::GET;
-        }
-        else if(req.indexOf("POST") == 0){
-          clientMethod = WebPath::POST;
-        }
-        //Get path and vars
-        int pathIdx = req.indexOf('/');
-        int varIdx = req.indexOf('?', pathIdx);
-        varIdx = varIdx < 0 ? req.indexOf(' ', pathIdx) : varIdx; //If there arent any vars set to the end of the uri
-        String path = req.substring(pathIdx, varIdx);
-        String vars {};
-        if(-1 < varIdx){
-          vars = req.substring(varIdx+1, req.indexOf(' ', varIdx));
-        }
-        String host {_getHost(client)};
-        print("Method: ");
-        println(clientMethod == WebPath::GET ? "GET" : "POST");
-        print("Path: ");
-        println(path);
-        print("Host: ");
-        print(host);
-        if(!vars.isEmpty()){
-          print("\nVars: ");
-          print(vars);
+      _tickStart = micros();
+      Time::Time_t now = Time::now(false).raw;
+      _accept(now);
+      //Start where the last tick left off so a busy connection can't starve the others
+      for(uint8_t n = 0; n < MAX_CONNECTIONS; ++n){
+        uint8_t i = (_nextConn + n) % MAX_CONNECTIONS;
+        if(!_conns[i].inUse){ continue; }
+        if(_outOfTime()){
+          _nextConn = i;
+          ++_stats.deferred;
+          return;
         }
-        println();
-        //Serve path's page
-        _servePage(client, clientMethod, path, vars, host);
+        _advance(_conns[i], now);
+      }
+      _nextConn = (_nextConn + 1) % MAX_CONNECTIONS;
+    }
+    //Lets each client IP make rate requests a second on average with bursts of up to burst, 0 turns it off
+    void setRateLimit(uint16_t rate, uint16_t burst){ _limiter.configure(rate, burst); }
+    //us processReq() can spend per call before leaving the rest for the next, 0 turns it off
+    void setTimeBudget(uint32_t us){ _timeBudget = us; }
+    //Keeps the header so callbacks can get it through HttpRequest::header()
+    //name has to stay valid (ie a string literal)
+    bool collectHeader(const char *name){
+      if(_headerCount >= MAX_HEADERS){ return false; }
+      _headerNames[_headerCount++] = name;
+      return true;
+    }
+    //Keeps the client of the request being handled open after its callback returns
+    //Whatever took the client over is responsible for ending it (ie EventStream)
+    void detachClient(){ _detached = true; }
+    //Answers a WebSocket upgrade request with 101 and keeps the client open (see detachClient)
+    //Returns false if the request isn't a valid upgrade, nothing is sent in that case
+    bool acceptWebSocket(WiFiClient &client, const HttpRequest &req){
+      StrView key {req.header("Sec-WebSocket-Key")};
+      char accept[WebSocket::ACCEPT_KEY_LEN + 1];
+      if(!req.header("Upgrade").equalsIgnoreCase("websocket") || key.empty()){ return false; }
+      if(!WebSocket::acceptKey(key.data, key.len, accept, sizeof(accept))){ return false; }
+      char buf[UPGRADE_HEADER_BYTES];
+      BufferPrint head{buf, sizeof(buf)}; //Sent in one write like a Response's
+      Net::writeHeader(head, Net::HTTP_RES_SWITCHING, nullptr);
+      head.println("Upgrade: websocket");
+      head.println("Connection: Upgrade");
+      head.print("Sec-WebSocket-Accept: ");
+      head.println(accept);
+      head.println();
+      client.write(reinterpret_cast<const uint8_t*>(buf), head.len);
+      detachClient();
+      return true;
+    }
+    uint16_t pathCount() const { return _router.count(); }
+    const Stats& stats() const { return _stats; }
+    const Response::Stats& responseStats() const { return _response.stats(); }
+    uint8_t connectionCount() const {
+      uint8_t count = 0;
+      for(uint8_t i = 0; i < MAX_CONNECTIONS; ++i){
+        if(_conns[i].inUse){ ++count; }
       }
-      Net::endClient(client);
+      return count;
     }
-    uint8_t pathCount() const { return _pathCount; }
   private:
+    static const uint8_t UPGRADE_HEADER_BYTES{160}; //acceptWebSocket's 101, it takes 129
+    //Slot for a client, holds the parse state of its request
+    struct Connection{
+      WiFiClient client;
+      bool inUse = false;
+      HttpRequest req;
+      Time::Time_t lastActivity = 0;
+      bool gotData = false; //Whether the client sent any of the current request yet
+      uint16_t requests = 0; //Requests served on this connection
+      uint32_t ip = 0; //Client's address, for the rate limiter
+      uint64_t bodyLeft = 0; //Bytes of the last request's body still to skip
+    };
     WiFiServer _server;
-    WebPath _paths[MAX_PATHS];
+    Router _router;
     String _host;
-    uint8_t _pathCount;
     uint16_t _port;
+    const char* _headerNames[MAX_HEADERS];
+    uint8_t _headerCount;
+    bool _detached;
+    Connection _conns[MAX_CONNECTIONS];
+    Response _response; //Only one request is served at a time
+    Stats _stats;
+    RateLimiter<MAX_CLIENT_IPS> _limiter;
+    uint32_t _timeBudget;
+    uint32_t _tickStart; //micros() at the start of processReq()
+    uint8_t _nextConn; //Connection processReq() starts with
     const char* _favicon;
     const char* _notFoundPage =
     #include "data/notFound.string"
     ;
-    bool _pathExists(const String &path){
-      for(int i = 0; i < _pathCount; ++i){
-        if(_paths[i].path == path){ return true; }
-      }
-      return false;
-    }
-    String _getHost(WiFiClient &client){
-      String line{};
-      int res = false;
-      bool maxReached = false;
-      do{
-        res = Net::bufReadStringUntil(client, line, '\n', Net::MAX_REQ_BYTES);
-        if(res == -1){ maxReached = true; }
-        else{ maxReached = false; }
-        if(!maxReached && line.indexOf("Host: ") == 0){ //Host line
-          line = line.substring(6);
-          line.trim();
-          return line;
+    //Takes waiting clients into free slots
+    //If every slot is taken, one that hasn't sent anything yet (ie a browser's speculative connection) is given up
+    void _accept(Time::Time_t now){
+      while(_server.hasClient()){
+        Connection *conn = nullptr;
+        Connection *idle = nullptr;
+        for(uint8_t i = 0; i < MAX_CONNECTIONS && conn == nullptr; ++i){
+          if(!_conns[i].inUse){ conn = &_conns[i]; }
+          else if(!_conns[i].gotData && (idle == nullptr || _conns[i].lastActivity < idle->lastActivity)){ idle = &_conns[i]; }
         }
-      } while(res > 0);
-      return String();
-    }
-    void _servePage(WiFiClient &c, uint8_t method, const String &path, const String &vars, const String &host){
-      uint8_t i = 0;
-      if(host.length() > 0){
-        if(host != _host && host != WiFi.softAPIP().toString()){
-          i = _pathCount; //Skip looking through web paths as this is not intended for the regular webserver
+        if(conn == nullptr){
+          if(idle == nullptr){ return; } //Leave it waiting until a slot frees up
+          _close(*idle);
+          conn = idle;
         }
+        conn->client = _server.accept();
+        conn->client.setNoDelay(true); //Responses go out in one write, no need to wait for more
+        conn->inUse = true;
+        conn->req.reset(_headerNames, _headerCount);
+        conn->lastActivity = now;
+        conn->gotData = false;
+        conn->requests = 0;
+        conn->bodyLeft = 0;
+        conn->ip = static_cast<uint32_t>(conn->client.remoteIP());
+        ++_stats.connections;
       }
-      //Find the webpath
-      for(; i < _pathCount; ++i){
-        if(_paths[i].path == path){ //Found it
-          if(_paths[i].methods & method == 0){ //Method not allowed
-            Net::sendHeader(c, Net::HTTP_RES_BAD_METH, "text/plain", _paths[i].methods);
-            c.println(Net::HTTP_RES_BAD_METH);
-            return;
+    }
+
+    //Feeds whatever the client sent into its request, serves it once it is complete
+    //Bytes after the end of a request are the start of the next one
+    void _advance(Connection &conn, Time::Time_t now){
+      uint8_t chunk[128];
+      int avail = conn.client.available();
+      if(avail <= 0){
+        Time::Time_t timeout = conn.requests > 0 && !conn.gotData ? KEEP_ALIVE_TIMEOUT : REQUEST_TIMEOUT;
+        if(!conn.client.connected() || now - conn.lastActivity >= timeout){ _close(conn); }
+        return;
+      }
+      conn.lastActivity = now;
+      while(avail > 0 && conn.inUse && !_outOfTime()){
+        int len = conn.client.read(chunk, avail < static_cast<int>(sizeof(chunk)) ? avail : sizeof(chunk));
+        if(len <= 0){ return; }
+        avail -= len;
+        size_t pos = 0;
+        while(pos < static_cast<size_t>(len) && conn.inUse){
+          if(conn.bodyLeft > 0){ //Bodies aren't used, only the query
+            size_t skip = conn.bodyLeft < len - pos ? conn.bodyLeft : len - pos;
+            conn.bodyLeft -= skip;
+            pos += skip;
+            continue;
           }
-          //Execute the webpage's callback function
-          if(_paths[i].callback == nullptr){
-            Net::sendHeader(c, Net::HTTP_RES_NOT_IMPL, "text/plain");
-            c.println(Net::HTTP_RES_NOT_IMPL);
-            return;
+          if(!conn.gotData){ //Start of a request
+            if(!_limiter.allow(conn.ip, now)){
+              _tooManyRequests(conn);
+              return;
+            }
+            conn.gotData = true;
+          }
+          size_t used = 0;
+          HttpRequest::Result res = conn.req.feed(chunk + pos, len - pos, used);
+          pos += used;
+          switch(res){
+            case HttpRequest::Result::NEED_MORE:
+              break;
+            case HttpRequest::Result::DONE:
+              _serve(conn);
+              break;
+            case HttpRequest::Result::URI_TOO_LONG:
+              _reject(conn, Net::HTTP_RES_URI_LEN);
+              break;
+            case HttpRequest::Result::HEADERS_TOO_LARGE:
+              _reject(conn, Net::HTTP_RES_HEADERS_LEN);
+              break;
+            case HttpRequest::Result::BAD:
+              _reject(conn, Net::HTTP_RES_BAD_REQ);
+              break;
           }
-          _paths[i].callback(c, method, vars);
-          break;
         }
       }
-      if(i >= _pathCount){ //Path not found
-        //Trick devices into thinking they have internet
-        if(path == "/generate_204"){ //Google
-          Net::sendHeader(c, Net::HTTP_RES_NO_CONTENT, "text/plain");
-        }
-        else if(path == "/hotspot-detect.html" || path == "/test/success.html"){ //Apple
-          Net::sendHeader(c, Net::HTTP_RES_OK, "text/html");
-          c.print("<HTML><HEAD><TITLE>Success</TITLE></HEAD><BODY>Success</BODY></HTML>");
-        }
-        else if(path == "/connecttest.txt"){ //Microsoft
-          Net::sendHeader(c, Net::HTTP_RES_OK, "text/plain");
-          c.print("Microsoft Connect Test");
-        }
-        else if(path == "/success.txt"){
-          Net::sendHeader(c, Net::HTTP_RES_OK, "text/plain");
-          c.println("success");
-        }
-        else if(path == "/canonical.html"){
-          Net::sendHeader(c, Net::HTTP_RES_OK, "text/html");
-          c.print(R"(<meta http-equiv="refresh" content="0;url=https://support.mozilla.org/kb/captive-portal"/>)");
-        }
-        else{
-          Net::sendHeader(c, Net::HTTP_RES_OK, "text/html");
-          c.println(_notFoundPage);
-        }
+    }
+
+    //Whether the connection can stay open after the request
+    //bodyLen is set to the length of the request's body
+    bool _canKeepAlive(const Connection &conn, uint64_t &bodyLen) const {
+      const HttpRequest &req = conn.req;
+      bodyLen = 0;
+      if(conn.requests + 1 >= MAX_KEEP_ALIVE_REQUESTS){ return false; }
+      //A body without a length can't be skipped to find the next request
+      if(!req.header("Transfer-Encoding").empty()){ return false; }
+      StrView length {req.header("Content-Length")};
+      if(!length.empty() && !length.toUInt(bodyLen)){ return false; }
+      StrView connection {req.header("Connection")};
+      if(req.http10()){ return connection.equalsIgnoreCase("keep-alive"); } //1.0 closes by default
+      return !connection.equalsIgnoreCase("close");
+    }
+
+    bool _outOfTime() const { return _timeBudget > 0 && micros() - _tickStart >= _timeBudget; }
+
+    //Answers with a fixed 429 without parsing the request and ends the connection
+    void _tooManyRequests(Connection &conn){
+      static const char RES[] = "HTTP/1.1 429 Too Many Requests\r\nRetry-After: 1\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+      conn.client.write(reinterpret_cast<const uint8_t*>(RES), sizeof(RES) - 1);
+      ++_stats.limited;
+      _close(conn);
+    }
+
+    //Answers with code (as the body too) through _response, the request is given up on so the connection is closed
+    void _reject(Connection &conn, const char *code){
+      _response.reset(&conn.client, false, false);
+      _response.send(code, "text/plain", code);
+      _response.finish();
+      print("Rejected request: ");
+      println(code);
+      _close(conn);
+    }
+
+    void _serve(Connection &conn){
+      const HttpRequest &req = conn.req;
+      uint64_t bodyLen = 0;
+      bool keepAlive = _canKeepAlive(conn, bodyLen);
+      print("New request: ");
+      print(conn.client.remoteIP().toString());
+      print(':');
+      print(conn.client.remotePort());
+      print('\n');
+      print("Method: ");
+      println(req.method() == WebPath::GET ? "GET" : "POST");
+      print("Path: ");
+      println(req.path());
+      print("Host: ");
+      println(req.host());
+      //Serve path's page
+      ++_stats.requests;
+      if(conn.requests > 0){ ++_stats.reused; }
+      _detached = false;
+      _response.reset(&conn.client, keepAlive, !req.http10());
+      _servePage(_response, req);
+      if(_detached){ //Whoever took the client keeps the socket open, just let go of it here
+        conn.client = WiFiClient();
+        conn.inUse = false;
+        return;
+      }
+      if(!_response.finish()){
+        _close(conn);
+        return;
+      }
+      //Wait for the next request
+      ++conn.requests;
+      conn.bodyLeft = bodyLen;
+      conn.gotData = false;
+      conn.req.reset(_headerNames, _headerCount);
+    }
+
+    void _close(Connection &conn){
+      Net::endClient(conn.client);
+      conn.inUse = false;
+    }
+
+    void _servePage(Response &res, const HttpRequest &req){
+      const StrView &host = req.host();
+      bool ourHost = true;
+      if(host.len > 0){
+        IPAddress apIP = WiFi.softAPIP();
+        char apHost[16];
+        snprintf(apHost, sizeof(apHost), "%u.%u.%u.%u", apIP[0], apIP[1], apIP[2], apIP[3]);
+        ourHost = host.equals(_host.c_str()) || host.equals(apHost); //Otherwise only the captive portal probes are served
+      }
+      const WebPath *path = nullptr;
+      switch(_router.find(req.path(), req.method(), ourHost, path)){
+        case Router::Result::FOUND:
+          if(path->callback == nullptr){
+            res.begin(Net::HTTP_RES_NOT_IMPL, "text/plain");
+            res.println(Net::HTTP_RES_NOT_IMPL);
+            return;
+          }
+          //Execute the webpage's callback function
+          path->callback(res, req);
+          break;
+        case Router::Result::BAD_METHOD:
+          res.begin(Net::HTTP_RES_BAD_METH, "text/plain", path->methods);
+          res.println(Net::HTTP_RES_BAD_METH);
+          break;
+        case Router::Result::NOT_FOUND:
+          res.send(Net::HTTP_RES_OK, "text/html", _notFoundPage);
+          break;
       }
     }
+
+    static void _probeGoogle(Response &res, const HttpRequest &req){
+      res.send(Net::HTTP_RES_NO_CONTENT);
+    }
+    static void _probeApple(Response &res, const HttpRequest &req){
+      res.send(Net::HTTP_RES_OK, "text/html", "<HTML><HEAD><TITLE>Success</TITLE></HEAD><BODY>Success</BODY></HTML>");
+    }
+    static void _probeMicrosoft(Response &res, const HttpRequest &req){
+      res.send(Net::HTTP_RES_OK, "text/plain", "Microsoft Connect Test");
+    }
+    static void _probeSuccess(Response &res, const HttpRequest &req){
+      res.send(Net::HTTP_RES_OK, "text/plain", "success\r\n");
+    }
+    static void _probeMozilla(Response &res, const HttpRequest &req){
+      res.send(Net::HTTP_RES_OK, "text/html", R"(<meta http-equiv="refresh" content="0;url=https://support.mozilla.org/kb/captive-portal"/>)");
+    }
 };
 #endif //WEBSERVER_H
\ No newline at end of file
@@ -0,0 +1,221 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+#include <WiFi.h>
+#include <mbedtls/sha1.h>
+#include <mbedtls/base64.h>
+#include "Networking.h"
+//Server side of WebSocket (RFC 6455), only small unfragmented frames
+namespace WebSocket{
+  const char *GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+  const uint8_t ACCEPT_KEY_LEN = 28; //Base64 of a SHA-1 hash
+  const uint8_t MAX_PAYLOAD = 125; //Largest payload that fits in the 7 bit length (and in a control frame)
+  const uint8_t MAX_FRAME_BYTES = 2 + MAX_PAYLOAD; //Frames sent by the server aren't masked
+
+  enum Opcode : uint8_t{
+    CONTINUATION = 0x0,
+    TEXT = 0x1,
+    BINARY = 0x2,
+    CLOSE = 0x8,
+    PING = 0x9,
+    PONG = 0xA
+  };
+  const uint8_t FIN = 0x80;
+  const uint8_t MASKED = 0x80;
+
+  //Writes the Sec-WebSocket-Accept value for key into out (null terminated)
+  //Returns false if out is too small
+  bool acceptKey(const char *key, size_t keyLen, char *out, size_t size){
+    const size_t GUID_LEN = 36;
+    const size_t MAX_KEY_LEN = 64;
+    if(size < ACCEPT_KEY_LEN + 1 || keyLen > MAX_KEY_LEN){ return false; }
+    uint8_t joined[MAX_KEY_LEN + GUID_LEN];
+    memcpy(joined, key, keyLen);
+    memcpy(joined + keyLen, GUID, GUID_LEN);
+    uint8_t hash[20];
+    mbedtls_sha1(joined, keyLen + GUID_LEN, hash);
+    size_t len = 0;
+    if(mbedtls_base64_encode(reinterpret_cast<uint8_t*>(out), size, &len, hash, sizeof(hash)) != 0){ return false; }
+    out[len] = '\0';
+    return true;
+  }
+
+  //Writes an unmasked frame into out (which needs room for MAX_FRAME_BYTES)
+  //Returns the length of the frame, 0 if payload is too big
+  uint8_t makeFrame(uint8_t *out, Opcode opcode, const uint8_t *payload, uint8_t len){
+    if(len > MAX_PAYLOAD){ return 0; }
+    out[0] = FIN | opcode;
+    out[1] = len;
+    memcpy(out + 2, payload, len);
+    return len + 2;
+  }
+};
+
+//Sends the same binary messages to up to MAX_CLIENTS WebSocket clients without blocking
+//A client that hasn't taken the whole previous frame yet misses the new one (counted in dropped())
+//so a slow client loses messages instead of holding up the caller
+//Pings are answered, anything else the clients send is ignored
+template<uint8_t MAX_CLIENTS>
+class WebSocketStream{
+  public:
+    WebSocketStream() : _clientCount(0), _dropped(0){}
+
+    bool hasRoom() const { return _clientCount < MAX_CLIENTS; }
+    //Takes over a client that finished the handshake (see WebServer::acceptWebSocket)
+    bool add(WiFiClient &client){
+      for(uint8_t i = 0; i < MAX_CLIENTS; ++i){
+        Subscriber &c = _clients[i];
+        if(c.active){ continue; }
+        c.client = client;
+        c.client.setNoDelay(true); //Frames are small, don't wait to batch them
+        c.pendingLen = 0;
+        c.rxLen = 0;
+        c.skip = 0;
+        c.active = true;
+        ++_clientCount;
+        return true;
+      }
+      return false;
+    }
+
+    //Sends payload as a binary frame to every client
+    void sendBinary(const uint8_t *payload, uint8_t len){
+      if(_clientCount == 0){ return; }
+      uint8_t frame[WebSocket::MAX_FRAME_BYTES];
+      uint8_t frameLen = WebSocket::makeFrame(frame, WebSocket::BINARY, payload, len);
+      if(frameLen == 0){ return; }
+      for(uint8_t i = 0; i < MAX_CLIENTS; ++i){
+        if(_clients[i].active){ _send(_clients[i], frame, frameLen); }
+      }
+    }
+
+    //Handles what the clients sent and finishes partly sent frames, call once per loop
+    void poll(){
+      for(uint8_t i = 0; i < MAX_CLIENTS; ++i){
+        Subscriber &c = _clients[i];
+        if(!c.active){ continue; }
+        if(!c.client.connected()){
+          _drop(c);
+          continue;
+        }
+        if(!_flushPending(c)){ continue; }
+        _receive(c);
+      }
+    }
+
+    uint8_t clientCount() const { return _clientCount; }
+    //Frames that weren't sent to a client because it was behind
+    uint32_t dropped() const { return _dropped; }
+  private:
+    static const uint8_t RX_BYTES = 14 + WebSocket::MAX_PAYLOAD; //Largest client frame header plus a control payload
+    struct Subscriber{
+      WiFiClient client;
+      uint8_t pending[WebSocket::MAX_FRAME_BYTES]; //Rest of a frame the socket didn't take
+      uint8_t pendingLen = 0;
+      uint8_t rx[RX_BYTES]; //Start of the frame being received
+      uint8_t rxLen = 0;
+      uint64_t skip = 0; //Payload bytes of a data frame left to throw away
+      bool active = false;
+    };
+    Subscriber _clients[MAX_CLIENTS];
+    uint8_t _clientCount;
+    uint32_t _dropped;
+
+    void _send(Subscriber &c, const uint8_t *frame, uint8_t len){
+      if(!_flushPending(c)){ return; }
+      if(c.pendingLen > 0){
+        ++_dropped;
+        return;
+      }
+      int res = Net::sendNoWait(c.client, frame, len);
+      if(res < 0){
+        _drop(c);
+        return;
+      }
+      //Keep the rest so the stream stays in sync, the next frames are dropped until it is out
+      c.pendingLen = len - res;
+      memcpy(c.pending, frame + res, c.pendingLen);
+    }
+
+    //Returns false if the client was dropped
+    bool _flushPending(Subscriber &c){
+      if(c.pendingLen == 0){ return true; }
+      int res = Net::sendNoWait(c.client, c.pending, c.pendingLen);
+      if(res < 0){
+        _drop(c);
+        return false;
+      }
+      c.pendingLen -= res;
+      memmove(c.pending, c.pending + res, c.pendingLen);
+      return true;
+    }
+
+    void _receive(Subscriber &c){
+      int avail = c.client.available();
+      if(avail > 0 && c.rxLen < RX_BYTES){
+        int res = c.client.read(c.rx + c.rxLen, RX_BYTES - c.rxLen);
+        if(res > 0){ c.rxLen += res; }
+      }
+      while(c.active){
+        if(c.skip > 0){
+          uint8_t n = c.skip < c.rxLen ? c.skip : c.rxLen;
+          _consume(c, n);
+          c.skip -= n;
+          if(c.skip > 0){ return; }
+          continue;
+        }
+        if(c.rxLen < 2){ return; }
+        uint8_t opcode = c.rx[0] & 0x0F;
+        if(!(c.rx[1] & WebSocket::MASKED)){ //Client frames must be masked (RFC 6455 5.1)
+          _drop(c);
+          return;
+        }
+        uint8_t len7 = c.rx[1] & 0x7F;
+        uint8_t extLen = len7 == 126 ? 2 : (len7 == 127 ? 8 : 0);
+        uint8_t headLen = 2 + extLen + 4;
+        if(c.rxLen < headLen){ return; }
+        uint64_t len = len7;
+        if(extLen > 0){
+          len = 0;
+          for(uint8_t i = 0; i < extLen; ++i){ len = (len << 8) | c.rx[2 + i]; }
+        }
+        if(opcode < WebSocket::CLOSE){ //Data isn't used
+          _consume(c, headLen);
+          c.skip = len;
+          continue;
+        }
+        if(len > WebSocket::MAX_PAYLOAD){ //Not allowed for control frames
+          _drop(c);
+          return;
+        }
+        if(c.rxLen < headLen + len){ return; }
+        uint8_t *payload = c.rx + headLen;
+        const uint8_t *mask = c.rx + 2 + extLen;
+        for(uint8_t i = 0; i < len; ++i){ payload[i] ^= mask[i % 4]; }
+        uint8_t frame[WebSocket::MAX_FRAME_BYTES];
+        if(opcode == WebSocket::PING){
+          _send(c, frame, WebSocket::makeFrame(frame, WebSocket::PONG, payload, len));
+        }
+        else if(opcode == WebSocket::CLOSE){ //Echo the close and end the connection
+          WebSocket::makeFrame(frame, WebSocket::CLOSE, payload, len < 2 ? len : 2);
+          Net::sendNoWait(c.client, frame, len < 2 ? 2 + len : 4);
+          _drop(c);
+          return;
+        }
+        _consume(c, headLen + len);
+      }
+    }
+
+    void _consume(Subscriber &c, uint8_t n){
+      c.rxLen -= n;
+      memmove(c.rx, c.rx + n, c.rxLen);
+    }
+
+    void _drop(Subscriber &c){
+      c.client.stop();
+      c.active = false;
+      --_clientCount;
+    }
+};
+#endif //WEBSOCKET_H
@@ -0,0 +1,19 @@
+#!/bin/bash
+#Makes a gzipped copy and a content hash of a .string file (see min.sh)
+#  name.gz.bytes holds the compressed content as a comma separated byte list
+#  name.etag.string holds the hash as a quoted ETag string literal
+#  name.gz.etag.string holds the gzipped copy's ETag, the same hash with -gz on the end
+if [ $# -eq 0 ]; then
+    echo "Usage: $0 string-file"
+    exit 1
+fi
+BASE=${1%.string}
+CONTENT=$(mktemp)
+#Strip the raw string delimiters so the content matches the string in the firmware
+perl -0777 -pe 's/\AR"\^~\(//; s/\)\^~"\n?\z//' $1 > $CONTENT
+gzip -9 -n -c $CONTENT | xxd -i > $BASE.gz.bytes
+HASH=$(sha256sum $CONTENT | cut -c1-16)
+echo "\"\\\"$HASH\\\"\"" > $BASE.etag.string
+echo "\"\\\"$HASH-gz\\\"\"" > $BASE.gz.etag.string
+echo "Compressed $1 to $BASE.gz.bytes ($(wc -c < $CONTENT) -> $(gzip -9 -n -c $CONTENT | wc -c) bytes)"
+rm $CONTENT
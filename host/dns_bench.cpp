@@ -0,0 +1,210 @@
+//Copyright 2026 Treevar
+//All rights reserved
+//Queries per second benchmark of the captive portal DNS server (inc/DNSServer.h)
+//handler: DNSServer::respond() called directly on the queries phones send when they join the AP, one after
+//         the other, each round CACHE_US later than the last so none are answered from the cache
+//burst:   the non-A ones (the ones that are cached) 4 times in a row like a client retrying, all but the first
+//         from the cache
+//udp:     the same queries over loopback to a DNSServer started on the HAL's AsyncUDP, window of them
+//         in flight at a time
+//Both count heap allocations per query, the server shouldn't make any
+//The server gets --domains more blocked domains (half of them wildcards) on top of the one the queries hit,
+//lookups shouldn't get slower with more of them
+//Usage: dns_bench [--host ip --port n] [--duration ms] [--window n] [--iterations n] [--domains n]
+//  --host/--port only runs udp, against a server that is already running (a unit is 192.168.4.1 53,
+//  car_stop_host is 127.0.0.1 8053), allocations aren't counted then
+#include <Arduino.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <vector>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "inc/DNSServer.h"
+
+namespace{
+  using Clock = std::chrono::steady_clock;
+
+  const uint16_t BENCH_PORT_OFFSET = 9000; //Away from a car_stop_host that may be running (see hal/WiFi.h)
+  const int REPLY_TIMEOUT_MS = 1000;
+  std::atomic<uint64_t> allocations{0};
+
+  struct Case{
+    const char *name;
+    uint16_t type;
+  };
+  const Case CASES[] = {
+    {"stop.light", DNSServer::Type::A},
+    {"connectivitycheck.gstatic.com", DNSServer::Type::A},
+    {"captive.apple.com", DNSServer::Type::A},
+    {"www.msftconnecttest.com", DNSServer::Type::A},
+    {"clients3.google.com", DNSServer::Type::AAAA},
+    {"captive.apple.com", DNSServer::Type::HTTPS},
+    {"blocked.example.com", DNSServer::Type::A}
+  };
+  const char *NX_DOMAIN = "blocked.example.com";
+
+  //Query for name as a stub resolver sends it, id goes in the first 2 bytes
+  std::vector<uint8_t> query(const char *name, uint16_t type){
+    std::vector<uint8_t> q = {0, 0, 0x01, 0x00, 0, 1, 0, 0, 0, 0, 0, 0}; //RD, 1 question
+    for(const char *label = name; *label != '\0';){
+      const char *dot = strchr(label, '.');
+      size_t len = dot != nullptr ? dot - label : strlen(label);
+      q.push_back(len);
+      q.insert(q.end(), label, label + len);
+      label += len + (dot != nullptr ? 1 : 0);
+    }
+    q.push_back(0);
+    q.push_back(type >> 8);
+    q.push_back(type & 0xff);
+    q.push_back(0);
+    q.push_back(1); //IN
+    return q;
+  }
+
+  void report(const char *phase, uint64_t queries, double seconds, uint64_t allocs, bool countAllocs){
+    printf("%-8s %10llu %12.0f %10.2f", phase, static_cast<unsigned long long>(queries), queries / seconds,
+      seconds * 1e9 / queries);
+    if(countAllocs){ printf(" %12.3f\n", static_cast<double>(allocs) / queries); }
+    else{ printf(" %12s\n", "-"); }
+  }
+
+  void handler(const char *phase, DNSServer &dns, const std::vector<std::vector<uint8_t>> &queries, uint32_t iterations,
+    uint8_t repeat){
+    volatile size_t replyBytes = 0; //Read after the loop so the replies can't be left unbuilt
+    uint64_t allocsBefore = allocations;
+    Clock::time_point start = Clock::now();
+    for(uint32_t i = 0; i < iterations; ++i){
+      uint32_t round = repeat > 1 ? 0 : i * DNSServer::CACHE_US; //Ages the cache out between rounds without repeats
+      for(const std::vector<uint8_t> &q : queries){
+        for(uint8_t r = 0; r < repeat; ++r){
+          const uint8_t *reply;
+          replyBytes = replyBytes + dns.respond(q.data(), q.size(), reply, micros() + round);
+        }
+      }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if(replyBytes == 0){ printf("%s: no replies\n", phase); }
+    report(phase, static_cast<uint64_t>(iterations) * queries.size() * repeat, seconds, allocations - allocsBefore, true);
+  }
+
+  //Returns false if the server stopped answering
+  bool udp(const sockaddr_in &server, std::vector<std::vector<uint8_t>> queries, uint32_t durationMs, uint32_t window,
+    bool countAllocs){
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if(fd < 0 || connect(fd, reinterpret_cast<const sockaddr*>(&server), sizeof(server)) < 0){
+      perror("dns_bench");
+      return false;
+    }
+    uint16_t id = 0;
+    size_t next = 0;
+    auto send = [&](){
+      std::vector<uint8_t> &q = queries[next++ % queries.size()];
+      ++id;
+      q[0] = id >> 8;
+      q[1] = id & 0xff;
+      ::send(fd, q.data(), q.size(), 0);
+    };
+    uint8_t reply[DNSServer::MAX_REPLY_BYTES];
+    uint64_t answered = 0;
+    uint64_t allocsBefore = allocations;
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = start + std::chrono::milliseconds(durationMs);
+    for(uint32_t i = 0; i < window; ++i){ send(); }
+    bool ok = true;
+    while(Clock::now() < end){
+      pollfd pfd{fd, POLLIN, 0};
+      if(poll(&pfd, 1, REPLY_TIMEOUT_MS) != 1){ //Dropped, put it back in flight
+        if(answered == 0){
+          ok = false;
+          break;
+        }
+        send();
+        continue;
+      }
+      if(recv(fd, reply, sizeof(reply), 0) > 0){
+        ++answered;
+        send();
+      }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    close(fd);
+    if(!ok){
+      printf("udp: no replies\n");
+      return false;
+    }
+    report("udp", answered, seconds, allocations - allocsBefore, countAllocs);
+    return true;
+  }
+};
+
+void* operator new(size_t size){
+  ++allocations;
+  void *p = malloc(size == 0 ? 1 : size);
+  if(p == nullptr){ throw std::bad_alloc(); }
+  return p;
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t size) noexcept { free(p); }
+
+int main(int argc, char **argv){
+  const char *host = nullptr;
+  uint16_t port = 0;
+  uint32_t durationMs = 3000;
+  uint32_t window = 8;
+  uint32_t iterations = 500000;
+  uint32_t domains = 200;
+  for(int i = 1; i + 1 < argc; i += 2){
+    if(strcmp(argv[i], "--host") == 0){ host = argv[i + 1]; }
+    else if(strcmp(argv[i], "--port") == 0){ port = atoi(argv[i + 1]); }
+    else if(strcmp(argv[i], "--duration") == 0){ durationMs = strtoul(argv[i + 1], nullptr, 10); }
+    else if(strcmp(argv[i], "--window") == 0){ window = strtoul(argv[i + 1], nullptr, 10); }
+    else if(strcmp(argv[i], "--iterations") == 0){ iterations = strtoul(argv[i + 1], nullptr, 10); }
+    else if(strcmp(argv[i], "--domains") == 0){ domains = strtoul(argv[i + 1], nullptr, 10); }
+    else{
+      printf("Unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+  std::vector<std::vector<uint8_t>> queries;
+  std::vector<std::vector<uint8_t>> nonA;
+  for(const Case &c : CASES){
+    queries.push_back(query(c.name, c.type));
+    if(c.type != DNSServer::Type::A){ nonA.push_back(queries.back()); }
+  }
+
+  sockaddr_in server{};
+  server.sin_family = AF_INET;
+  printf("%-8s %10s %12s %10s %12s\n", "phase", "queries", "qps", "ns/query", "allocs/query");
+  if(host != nullptr){
+    server.sin_port = htons(port);
+    if(inet_pton(AF_INET, host, &server.sin_addr) != 1){
+      printf("Bad host %s\n", host);
+      return 1;
+    }
+    return udp(server, queries, durationMs, window, false) ? 0 : 1;
+  }
+
+  char offset[8];
+  snprintf(offset, sizeof(offset), "%u", BENCH_PORT_OFFSET);
+  setenv("HAL_PORT_OFFSET", offset, 0);
+  static DNSServer dns;
+  dns.addNXDomain(NX_DOMAIN);
+  for(uint32_t i = 0; i < domains; ++i){
+    char domain[40];
+    snprintf(domain, sizeof(domain), i % 2 == 0 ? "telemetry%u.example.net" : "*.updates%u.example.org", i);
+    if(!dns.addNXDomain(domain)){
+      printf("Only room for %u domains\n", i + 1);
+      break;
+    }
+  }
+  if(!dns.start(IPAddress(192, 168, 4, 1))){ return 1; }
+  handler("handler", dns, queries, iterations, 1);
+  handler("burst", dns, nonA, iterations * queries.size() / nonA.size() / 4, 4);
+  server.sin_port = htons(Hal::hostPort(53));
+  server.sin_addr.s_addr = Hal::bindAddr();
+  bool ok = udp(server, queries, durationMs, window, true);
+  dns.stop();
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+//Copyright 2026 Treevar
+//All rights reserved
+//Checks DNSServer's replies to a corpus of queries (host/dns_corpus.txt, the format is at its top)
+//Every reply has to have the query's id and opcode, the expected code and counts, the question as it was
+//sent and the expected IP as the answer
+//Every query is asked again with another id, that reply (from the cache if it isn't an A query) has to pass the same checks
+//Every query is also cut short at each length, those replies only have to fit MAX_REPLY_BYTES
+//(build with -DHOST_SANITIZE=ON to catch reads past the end)
+//Usage: dns_check corpus
+#include <Arduino.h>
+#include <string>
+#include <vector>
+#include "inc/DNSServer.h"
+
+namespace{
+  const IPAddress AP_IP{192, 168, 4, 1};
+  struct Domain{
+    const char *domain;
+    IPAddress ip; //0.0.0.0 for NXDOMAIN
+  };
+  const Domain DOMAINS[] = {
+    {"blocked.example.com", IPAddress()},
+    {"*.events.example.com", IPAddress()},
+    {"printer.example.com", IPAddress(192, 168, 4, 20)},
+    {"*.lan.example", IPAddress(192, 168, 4, 30)},
+    {"exact.lan.example", IPAddress()}
+  };
+
+  struct Expect{
+    bool reply = true;
+    uint8_t rCode = DNSServer::ResCode::NOERROR;
+    bool answer = false;
+    IPAddress ip = AP_IP;
+    bool question = true;
+    bool opt = false;
+  };
+
+  bool parseExpect(std::string s, Expect &expect){
+    size_t plus = s.find("+opt");
+    if(plus != std::string::npos){
+      expect.opt = true;
+      s.erase(plus);
+    }
+    if(s.compare(0, 2, "A=") == 0){
+      expect.answer = true;
+      return expect.ip.fromString(s.c_str() + 2);
+    }
+    if(s == "A"){ expect.answer = true; }
+    else if(s == "EMPTY"){}
+    else if(s == "NX"){ expect.rCode = DNSServer::ResCode::NXDOMAIN; }
+    else if(s == "FORMERR"){
+      expect.rCode = DNSServer::ResCode::FORMERR;
+      expect.question = false;
+    }
+    else if(s == "NOTIMP"){
+      expect.rCode = DNSServer::ResCode::NOTIMP;
+      expect.question = false;
+    }
+    else if(s == "DROP"){ expect.reply = false; }
+    else{ return false; }
+    return true;
+  }
+
+  bool parseHex(const std::string &hex, std::vector<uint8_t> &out){
+    if(hex.size() % 2 != 0){ return false; }
+    for(size_t i = 0; i < hex.size(); i += 2){
+      char *end;
+      std::string byte = hex.substr(i, 2);
+      out.push_back(strtoul(byte.c_str(), &end, 16));
+      if(*end != '\0'){ return false; }
+    }
+    return true;
+  }
+
+  uint16_t read16(const uint8_t *data){ return (data[0] << 8) | data[1]; }
+
+  //Length of the first question, the corpus doesn't compress it
+  size_t questionLength(const std::vector<uint8_t> &query){
+    size_t pos = DNSServer::DNS_HEADER_SIZE;
+    while(pos < query.size() && query[pos] != 0){ pos += query[pos] + 1; }
+    return pos + 5 - DNSServer::DNS_HEADER_SIZE; //Root label + Type + Class
+  }
+
+  //Returns what is wrong with the reply, nullptr if nothing
+  const char* check(const std::vector<uint8_t> &query, const Expect &expect, const uint8_t *reply, size_t length){
+    if(!expect.reply){ return length == 0 ? nullptr : "replied"; }
+    if(length < DNSServer::DNS_HEADER_SIZE){ return "no reply"; }
+    if(memcmp(reply, query.data(), 2) != 0){ return "id"; }
+    if((reply[2] & 0x80) == 0){ return "not a response"; }
+    if((reply[2] & 0x78) != (query[2] & 0x78)){ return "opcode"; }
+    if((reply[3] & 0x0f) != expect.rCode){ return "rcode"; }
+    if(read16(reply + 4) != (expect.question ? 1 : 0)){ return "question count"; }
+    if(read16(reply + 6) != (expect.answer ? 1 : 0)){ return "answer count"; }
+    if(read16(reply + 8) != 0){ return "authority count"; }
+    if(read16(reply + 10) != (expect.opt ? 1 : 0)){ return "additional count"; }
+    size_t qLength = expect.question ? questionLength(query) : 0;
+    size_t expected = DNSServer::DNS_HEADER_SIZE + qLength + (expect.answer ? DNSServer::ANSWER_SIZE : 0) +
+      (expect.opt ? DNSServer::OPT_SIZE : 0);
+    if(length != expected){ return "length"; }
+    const uint8_t *pos = reply + DNSServer::DNS_HEADER_SIZE;
+    if(memcmp(pos, query.data() + DNSServer::DNS_HEADER_SIZE, qLength) != 0){ return "question"; }
+    pos += qLength;
+    if(expect.answer){
+      const uint8_t answer[] = {DNSServer::POINTER_BYTE, DNSServer::DNS_HEADER_SIZE, 0, DNSServer::Type::A, 0, 1};
+      if(memcmp(pos, answer, sizeof(answer)) != 0 || read16(pos + 10) != 4){ return "answer"; }
+      for(uint8_t i = 0; i < 4; ++i){
+        if(pos[12 + i] != expect.ip[i]){ return "answer IP"; }
+      }
+      pos += DNSServer::ANSWER_SIZE;
+    }
+    if(expect.opt && (pos[0] != 0 || read16(pos + 1) != DNSServer::Type::OPT || read16(pos + 9) != 0)){ return "OPT"; }
+    return nullptr;
+  }
+};
+
+int main(int argc, char **argv){
+  if(argc < 2){
+    printf("Usage: dns_check corpus\n");
+    return 1;
+  }
+  FILE *file = fopen(argv[1], "r");
+  if(file == nullptr){
+    perror(argv[1]);
+    return 1;
+  }
+  setenv("HAL_PORT_OFFSET", "10000", 0); //Away from a car_stop_host or dns_bench that may be running (see hal/WiFi.h)
+  static DNSServer dns;
+  for(const Domain &d : DOMAINS){
+    if(!(d.ip == IPAddress() ? dns.addNXDomain(d.domain) : dns.addDomain(d.domain, d.ip))){
+      printf("Couldn't add %s\n", d.domain);
+      return 1;
+    }
+  }
+  if(!dns.start(AP_IP)){ return 1; }
+  dns.stop(); //respond() doesn't need the socket
+
+  unsigned queries = 0;
+  unsigned failed = 0;
+  char line[2048];
+  for(unsigned lineNum = 1; fgets(line, sizeof(line), file) != nullptr; ++lineNum){
+    char name[64], expectStr[24], hex[1536];
+    if(line[0] == '#' || line[0] == '\n'){ continue; }
+    Expect expect;
+    std::vector<uint8_t> query;
+    if(sscanf(line, "%63s %23s %1535s", name, expectStr, hex) != 3 || !parseExpect(expectStr, expect) || !parseHex(hex, query)){
+      printf("%s:%u: malformed line\n", argv[1], lineNum);
+      ++failed;
+      continue;
+    }
+    ++queries;
+    const uint8_t *reply;
+    size_t length = dns.respond(query.data(), query.size(), reply);
+    const char *error = check(query, expect, reply, length);
+    if(error == nullptr && query.size() >= 2){
+      query[0] ^= 0xff;
+      length = dns.respond(query.data(), query.size(), reply);
+      error = check(query, expect, reply, length);
+      if(error != nullptr){ error = "cached reply"; }
+    }
+    for(size_t cut = 0; cut < query.size() && error == nullptr; ++cut){
+      std::vector<uint8_t> part(query.begin(), query.begin() + cut); //Its own allocation so ASan sees the end
+      if(dns.respond(part.data(), part.size(), reply) > DNSServer::MAX_REPLY_BYTES){ error = "cut short reply too long"; }
+    }
+    if(error != nullptr){
+      printf("%-20s FAIL %s\n", name, error);
+      ++failed;
+    }
+  }
+  fclose(file);
+  printf("%u queries, %u failed\n", queries, failed);
+  return failed == 0 ? 0 : 1;
+}
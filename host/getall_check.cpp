@@ -0,0 +1,106 @@
+//Copyright 2026 Treevar
+//All rights reserved
+//Checks that /getall lists the data points it should, with the firmware running in this process
+//  /getall          every data point, changed since boot or not
+//  /getall?f=s1     every settable one
+//  /getall?since=n  none of the persistent ones (settings) right after a response with seq n
+//loop() runs on the main thread while a second one sends the requests over loopback
+//Usage: getall_check
+#include <Arduino.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <signal.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "car_stop.ino"
+
+namespace{
+  const char *CHECK_PORT_OFFSET = "11000"; //Away from a car_stop_host or bench that may be running (see hal/WiFi.h)
+  const unsigned long TIMEOUT_MS = 10000;
+
+  //Body of GET path over HTTP/1.0 (so it isn't chunked), empty if the request failed
+  std::string get(const char *path){
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(Hal::hostPort(80));
+    addr.sin_addr.s_addr = Hal::bindAddr();
+    if(fd < 0 || connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0){
+      perror("getall_check");
+      if(fd >= 0){ close(fd); }
+      return std::string();
+    }
+    std::string req = std::string("GET ") + path + " HTTP/1.0\r\nHost: stop.light\r\n\r\n";
+    send(fd, req.data(), req.size(), 0);
+    std::string res;
+    char buf[1024];
+    ssize_t n;
+    while((n = recv(fd, buf, sizeof(buf), 0)) > 0){ res.append(buf, n); }
+    close(fd);
+    size_t body = res.find("\r\n\r\n");
+    if(res.compare(0, 12, "HTTP/1.1 200") != 0 || body == std::string::npos){ return std::string(); }
+    return res.substr(body + 4);
+  }
+
+  bool listed(const std::string &body, const DataPoint &dp){
+    return body.find("\"" + std::string(dp.name, dp.nameLen) + "\":{") != std::string::npos;
+  }
+
+  //Returns the number of failures
+  unsigned check(){
+    unsigned failed = 0;
+    std::string all = get("/getall");
+    std::string settable = get("/getall?f=s1");
+    if(all.empty() || settable.empty()){
+      printf("FAIL no response\n");
+      return 1;
+    }
+    for(uint16_t i = 0; i < dataPoints.count(); ++i){
+      const DataPoint &dp {dataPoints.get(i)};
+      if(!listed(all, dp)){
+        printf("FAIL /getall is missing %.*s\n", dp.nameLen, dp.name);
+        ++failed;
+      }
+      if(dp.settable != listed(settable, dp)){
+        printf("FAIL /getall?f=s1 %s %.*s\n", dp.settable ? "is missing" : "lists", dp.nameLen, dp.name);
+        ++failed;
+      }
+    }
+    //Settings don't change between the two requests, readings and counters may
+    size_t seqAt = all.find("\"seq\":");
+    std::string since = "/getall?since=" + std::to_string(strtoul(all.c_str() + seqAt + 6, nullptr, 10));
+    std::string delta = get(since.c_str());
+    for(uint16_t i = 0; i < dataPoints.count(); ++i){
+      const DataPoint &dp {dataPoints.get(i)};
+      if(dp.persistent && listed(delta, dp)){
+        printf("FAIL %s lists %.*s, it didn't change\n", since.c_str(), dp.nameLen, dp.name);
+        ++failed;
+      }
+    }
+    printf("%u data points, %u failed\n", dataPoints.count(), failed);
+    return failed;
+  }
+};
+
+int main(){
+  setenv("HAL_PORT_OFFSET", CHECK_PORT_OFFSET, 0);
+  signal(SIGPIPE, SIG_IGN);
+  setup();
+  std::atomic<bool> done{false};
+  unsigned failed = 0;
+  std::thread client([&](){
+    failed = check();
+    done = true;
+  });
+  unsigned long start = millis();
+  while(!done && millis() - start < TIMEOUT_MS){ loop(); }
+  if(!done){
+    printf("FAIL timed out\n");
+    _exit(1);
+  }
+  client.join();
+  return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,27 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#include <Adafruit_NeoPixel.h>
+
+void Adafruit_NeoPixel::fill(uint32_t color, uint16_t first, uint16_t count){
+  size_t end = count == 0 ? _pixels.size() : first + count;
+  for(size_t i = first; i < end && i < _pixels.size(); ++i){ _pixels[i] = color; }
+}
+
+void Adafruit_NeoPixel::show(){
+  ++_shows;
+  if(!_frames.empty() && _frames.back().pixels == _pixels){ return; }
+  if(_frames.size() >= MAX_FRAMES){ _frames.erase(_frames.begin()); }
+  _frames.push_back({millis(), _pixels});
+  static FILE *log = nullptr;
+  static bool opened = false;
+  if(!opened){
+    opened = true;
+    const char *path = getenv("HAL_NEOPIXEL_LOG");
+    if(path != nullptr){ log = fopen(path, "w"); }
+  }
+  if(log == nullptr){ return; }
+  fprintf(log, "%lu", _frames.back().ms);
+  for(uint32_t color : _pixels){ fprintf(log, " %06x", color); }
+  fputc('\n', log);
+  fflush(log);
+}
@@ -0,0 +1,45 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef HAL_ADAFRUIT_NEOPIXEL_H
+#define HAL_ADAFRUIT_NEOPIXEL_H
+//Host stand-in for Adafruit_NeoPixel that records what the strip shows
+//Every show() that changes the strip is kept as a frame (the last MAX_FRAMES of them),
+//and appended to the file named by HAL_NEOPIXEL_LOG when it is set as "ms color color ..." in hex
+#include <Arduino.h>
+#include <vector>
+
+#define NEO_RGB 0x06
+#define NEO_GRB 0x52
+#define NEO_KHZ800 0x0000
+
+class Adafruit_NeoPixel{
+  public:
+    static const size_t MAX_FRAMES = 1024;
+    struct Frame{
+      unsigned long ms; //millis() when it was shown
+      std::vector<uint32_t> pixels; //0xRRGGBB
+    };
+    Adafruit_NeoPixel(uint16_t count, int16_t pin, uint16_t type = NEO_GRB + NEO_KHZ800) : _pixels(count, 0), _pin(pin), _brightness(0){}
+
+    bool begin(){ return true; }
+    void show();
+    void clear(){ fill(0); }
+    void fill(uint32_t color, uint16_t first = 0, uint16_t count = 0);
+    void setPixelColor(uint16_t idx, uint32_t color){ if(idx < _pixels.size()){ _pixels[idx] = color; } }
+    void setPixelColor(uint16_t idx, uint8_t r, uint8_t g, uint8_t b){ setPixelColor(idx, Color(r, g, b)); }
+    uint32_t getPixelColor(uint16_t idx) const { return idx < _pixels.size() ? _pixels[idx] : 0; }
+    void setBrightness(uint8_t brightness){ _brightness = brightness; }
+    uint8_t getBrightness() const { return _brightness; }
+    uint16_t numPixels() const { return _pixels.size(); }
+    static constexpr uint32_t Color(uint8_t r, uint8_t g, uint8_t b){ return (static_cast<uint32_t>(r) << 16) | (static_cast<uint32_t>(g) << 8) | b; }
+
+    const std::vector<Frame>& frames() const { return _frames; }
+    uint32_t shows() const { return _shows; } //show() calls, changed or not
+  private:
+    std::vector<uint32_t> _pixels;
+    int16_t _pin;
+    uint8_t _brightness;
+    std::vector<Frame> _frames;
+    uint32_t _shows = 0;
+};
+#endif //HAL_ADAFRUIT_NEOPIXEL_H
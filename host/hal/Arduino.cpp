@@ -0,0 +1,54 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#include <Arduino.h>
+#include <Wire.h>
+#include <chrono>
+#include <thread>
+#include <stdarg.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+TwoWire Wire;
+
+namespace{
+  using Clock = std::chrono::steady_clock;
+  uint8_t pins[64];
+
+  //Set on first use, the firmware's globals can call millis() before this file's would be constructed
+  Clock::duration sinceBoot(){
+    static const Clock::time_point boot = Clock::now();
+    return Clock::now() - boot;
+  }
+};
+
+unsigned long millis(){
+  return std::chrono::duration_cast<std::chrono::milliseconds>(sinceBoot()).count();
+}
+
+unsigned long micros(){
+  return std::chrono::duration_cast<std::chrono::microseconds>(sinceBoot()).count();
+}
+
+void delay(unsigned long ms){ std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+void delayMicroseconds(unsigned int us){ std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+
+void yield(){ std::this_thread::yield(); }
+
+void pinMode(uint8_t pin, uint8_t mode){}
+
+void digitalWrite(uint8_t pin, uint8_t value){
+  if(pin < sizeof(pins)){ pins[pin] = value; }
+}
+
+int digitalRead(uint8_t pin){ return pin < sizeof(pins) ? pins[pin] : LOW; }
+
+size_t Print::printf(const char *format, ...){
+  char buf[256];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if(len < 0){ return 0; }
+  return write(buf, static_cast<size_t>(len) < sizeof(buf) ? len : sizeof(buf) - 1);
+}
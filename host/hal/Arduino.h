@@ -0,0 +1,279 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef HAL_ARDUINO_H
+#define HAL_ARDUINO_H
+//Host stand-in for the Arduino core, enough of it for the firmware to build and run on Linux
+//Time comes from the monotonic clock, pins only remember what was written to them
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <limits.h>
+#include <ctype.h>
+#include <math.h>
+#include <arpa/inet.h>
+#include <string>
+#include <utility>
+
+typedef unsigned int uint;
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+inline bool isDigit(char c){ return c >= '0' && c <= '9'; }
+inline bool isAlpha(char c){ return isalpha(static_cast<unsigned char>(c)) != 0; }
+inline bool isSpace(char c){ return isspace(static_cast<unsigned char>(c)) != 0; }
+
+//Arduino's String on top of std::string
+class String{
+  public:
+    String(){}
+    String(const char *str){ if(str != nullptr){ _s = str; } }
+    String(const std::string &str) : _s(str){}
+    explicit String(char c) : _s(1, c){}
+    String(int v) : _s(std::to_string(v)){}
+    String(unsigned v) : _s(std::to_string(v)){}
+    String(long v) : _s(std::to_string(v)){}
+    String(unsigned long v) : _s(std::to_string(v)){}
+    String(long long v) : _s(std::to_string(v)){}
+    String(unsigned long long v) : _s(std::to_string(v)){}
+    String(float v, unsigned decimals = 2) : String(static_cast<double>(v), decimals){}
+    String(double v, unsigned decimals = 2){
+      char buf[32];
+      snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+      _s = buf;
+    }
+
+    unsigned length() const { return _s.size(); }
+    bool isEmpty() const { return _s.empty(); }
+    const char* c_str() const { return _s.c_str(); }
+    bool reserve(unsigned size){ _s.reserve(size); return true; }
+
+    char operator[](unsigned idx) const { return idx < _s.size() ? _s[idx] : '\0'; }
+    char& operator[](unsigned idx){ return _s[idx]; }
+    char charAt(unsigned idx) const { return (*this)[idx]; }
+    void setCharAt(unsigned idx, char c){ if(idx < _s.size()){ _s[idx] = c; } }
+
+    int indexOf(char c, unsigned from = 0) const { return _pos(_s.find(c, from)); }
+    int indexOf(const String &str, unsigned from = 0) const { return _pos(_s.find(str._s, from)); }
+    int lastIndexOf(char c) const { return _pos(_s.rfind(c)); }
+    int lastIndexOf(char c, unsigned from) const { return _pos(_s.rfind(c, from)); }
+    int lastIndexOf(const String &str) const { return _pos(_s.rfind(str._s)); }
+    String substring(unsigned begin) const { return begin >= _s.size() ? String() : String(_s.substr(begin)); }
+    String substring(unsigned begin, unsigned end) const {
+      if(begin > end){ std::swap(begin, end); }
+      if(begin >= _s.size()){ return String(); }
+      if(end > _s.size()){ end = _s.size(); }
+      return String(_s.substr(begin, end - begin));
+    }
+    bool startsWith(const String &prefix) const { return _s.compare(0, prefix._s.size(), prefix._s) == 0; }
+    bool endsWith(const String &suffix) const {
+      return _s.size() >= suffix._s.size() && _s.compare(_s.size() - suffix._s.size(), suffix._s.size(), suffix._s) == 0;
+    }
+
+    void trim(){
+      size_t begin = _s.find_first_not_of(" \t\r\n");
+      if(begin == std::string::npos){
+        _s.clear();
+        return;
+      }
+      _s = _s.substr(begin, _s.find_last_not_of(" \t\r\n") - begin + 1);
+    }
+    void replace(const String &find, const String &with){
+      if(find._s.empty()){ return; }
+      for(size_t pos = _s.find(find._s); pos != std::string::npos; pos = _s.find(find._s, pos + with._s.size())){
+        _s.replace(pos, find._s.size(), with._s);
+      }
+    }
+    void toLowerCase(){ for(char &c : _s){ c = tolower(static_cast<unsigned char>(c)); } }
+    void toUpperCase(){ for(char &c : _s){ c = toupper(static_cast<unsigned char>(c)); } }
+    long toInt() const { return atol(_s.c_str()); }
+    float toFloat() const { return atof(_s.c_str()); }
+
+    bool concat(const char *str, unsigned len){ _s.append(str, len); return true; }
+    bool concat(const String &str){ _s += str._s; return true; }
+    bool concat(char c){ _s += c; return true; }
+    String& operator+=(const String &str){ _s += str._s; return *this; }
+    String& operator+=(const char *str){ _s += str; return *this; }
+    String& operator+=(char c){ _s += c; return *this; }
+    String& operator+=(int v){ _s += std::to_string(v); return *this; }
+    String& operator+=(unsigned v){ _s += std::to_string(v); return *this; }
+    String& operator+=(long v){ _s += std::to_string(v); return *this; }
+    String& operator+=(unsigned long v){ _s += std::to_string(v); return *this; }
+
+    bool equals(const String &str) const { return _s == str._s; }
+    bool equals(const char *str) const { return _s == str; }
+    bool equalsIgnoreCase(const String &str) const { return strcasecmp(_s.c_str(), str._s.c_str()) == 0; }
+    bool operator==(const String &str) const { return _s == str._s; }
+    bool operator==(const char *str) const { return _s == str; }
+    bool operator!=(const String &str) const { return _s != str._s; }
+    bool operator!=(const char *str) const { return _s != str; }
+    bool operator<(const String &str) const { return _s < str._s; }
+
+    friend String operator+(const String &a, const String &b){ return String(a._s + b._s); }
+    friend String operator+(const char *a, const String &b){ return String(a + b._s); }
+    friend String operator+(const String &a, const char *b){ return String(a._s + b); }
+    friend String operator+(const String &a, char b){ return String(a._s + b); }
+  private:
+    std::string _s;
+
+    static int _pos(size_t pos){ return pos == std::string::npos ? -1 : static_cast<int>(pos); }
+};
+
+class Print;
+class Printable{
+  public:
+    virtual ~Printable(){}
+    virtual size_t printTo(Print &p) const = 0;
+};
+
+class Print{
+  public:
+    virtual ~Print(){}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *data, size_t len){
+      size_t n = 0;
+      while(len-- > 0){ n += write(*data++); }
+      return n;
+    }
+    size_t write(const char *data, size_t len){ return write(reinterpret_cast<const uint8_t*>(data), len); }
+    size_t write(const char *str){ return str == nullptr ? 0 : write(str, strlen(str)); }
+    virtual void flush(){}
+
+    size_t print(const char *str){ return write(str); }
+    size_t print(const String &str){ return write(str.c_str(), str.length()); }
+    size_t print(char c){ return write(static_cast<uint8_t>(c)); }
+    size_t print(int v){ return _printf("%d", v); }
+    size_t print(unsigned v){ return _printf("%u", v); }
+    size_t print(long v){ return _printf("%ld", v); }
+    size_t print(unsigned long v){ return _printf("%lu", v); }
+    size_t print(long long v){ return _printf("%lld", v); }
+    size_t print(unsigned long long v){ return _printf("%llu", v); }
+    size_t print(double v, int decimals = 2){ return _printf("%.*f", decimals, v); }
+    size_t print(const Printable &p){ return p.printTo(*this); }
+    size_t println(){ return write("\r\n"); }
+    template<typename T>
+    size_t println(const T &v){
+      size_t n = print(v);
+      return n + println();
+    }
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+  private:
+    template<typename... Args>
+    size_t _printf(const char *format, Args... args){
+      char buf[32];
+      int len = snprintf(buf, sizeof(buf), format, args...);
+      return len < 0 ? 0 : write(buf, len);
+    }
+};
+
+class Stream : public Print{
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    void setTimeout(unsigned long timeout){ _timeout = timeout; }
+
+    size_t readBytes(char *buf, size_t len){
+      size_t n = 0;
+      for(int c; n < len && (c = _timedRead()) >= 0;){ buf[n++] = static_cast<char>(c); }
+      return n;
+    }
+    size_t readBytesUntil(char terminator, char *buf, size_t len){
+      size_t n = 0;
+      for(int c; n < len && (c = _timedRead()) >= 0 && c != terminator;){ buf[n++] = static_cast<char>(c); }
+      return n;
+    }
+  protected:
+    unsigned long _timeout = 1000;
+
+    int _timedRead(){
+      unsigned long start = millis();
+      do{
+        int c = read();
+        if(c >= 0){ return c; }
+        yield();
+      } while(millis() - start < _timeout);
+      return -1;
+    }
+};
+
+//Serial goes to stdout, nothing is ever read from it
+class HardwareSerial : public Stream{
+  public:
+    void begin(unsigned long baud){}
+    using Print::write;
+    size_t write(uint8_t c) override { return fwrite(&c, 1, 1, stdout); }
+    size_t write(const uint8_t *data, size_t len) override { return fwrite(data, 1, len, stdout); }
+    void flush() override { fflush(stdout); }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    explicit operator bool() const { return true; }
+};
+extern HardwareSerial Serial;
+
+enum IPType{ IPv4, IPv6 };
+//IPv4 address, bytes are kept in network order like lwIP's
+class IPAddress : public Printable{
+  public:
+    IPAddress(){}
+    IPAddress(uint32_t addr){ memcpy(_bytes, &addr, 4); }
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _bytes{a, b, c, d}{}
+
+    uint8_t operator[](int idx) const { return _bytes[idx]; }
+    operator uint32_t() const {
+      uint32_t addr;
+      memcpy(&addr, _bytes, 4);
+      return addr;
+    }
+    bool operator==(const IPAddress &other) const { return memcmp(_bytes, other._bytes, 4) == 0; }
+    bool operator!=(const IPAddress &other) const { return !(*this == other); }
+    IPType type() const { return IPv4; }
+
+    bool fromString(const char *str){
+      unsigned parts[4];
+      char extra;
+      if(sscanf(str, "%u.%u.%u.%u%c", &parts[0], &parts[1], &parts[2], &parts[3], &extra) != 4){ return false; }
+      for(uint8_t i = 0; i < 4; ++i){
+        if(parts[i] > 255){ return false; }
+        _bytes[i] = parts[i];
+      }
+      return true;
+    }
+    bool fromString(const String &str){ return fromString(str.c_str()); }
+    String toString() const {
+      char buf[16];
+      snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _bytes[0], _bytes[1], _bytes[2], _bytes[3]);
+      return String(buf);
+    }
+    size_t printTo(Print &p) const override { return p.print(toString()); }
+  private:
+    uint8_t _bytes[4] = {0, 0, 0, 0};
+};
+
+class EspClass{
+  public:
+    uint64_t getEfuseMac(){ return 0x0000A1B2C3D4E5F6ULL; }
+    uint32_t getFreeHeap(){ return 200 * 1024; }
+    void restart(){ exit(0); }
+};
+extern EspClass ESP;
+#endif //HAL_ARDUINO_H
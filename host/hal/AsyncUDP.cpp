@@ -0,0 +1,58 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#include <AsyncUDP.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+namespace{
+  const int POLL_MS = 50; //How long close() can wait for the thread to notice
+  const size_t MAX_PACKET_BYTES = 1460; //Largest datagram lwIP hands over without fragments
+};
+
+size_t AsyncUDPPacket::reply(const uint8_t *data, size_t len){
+  ssize_t sent = sendto(_fd, data, len, 0, reinterpret_cast<const sockaddr*>(&_from), sizeof(_from));
+  return sent < 0 ? 0 : sent;
+}
+
+bool AsyncUDP::listen(uint16_t port){
+  close();
+  _fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if(_fd < 0){ return false; }
+  int reuse = 1;
+  setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(Hal::hostPort(port));
+  addr.sin_addr.s_addr = Hal::bindAddr();
+  if(bind(_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0){
+    perror("AsyncUDP");
+    ::close(_fd);
+    _fd = -1;
+    return false;
+  }
+  _running = true;
+  _thread = std::thread(&AsyncUDP::_run, this);
+  return true;
+}
+
+void AsyncUDP::close(){
+  _running = false;
+  if(_thread.joinable()){ _thread.join(); }
+  if(_fd >= 0){ ::close(_fd); }
+  _fd = -1;
+}
+
+void AsyncUDP::_run(){
+  uint8_t buf[MAX_PACKET_BYTES];
+  while(_running){
+    pollfd pfd{_fd, POLLIN, 0};
+    if(poll(&pfd, 1, POLL_MS) != 1){ continue; }
+    sockaddr_in from{};
+    socklen_t fromLen = sizeof(from);
+    ssize_t len = recvfrom(_fd, buf, sizeof(buf), 0, reinterpret_cast<sockaddr*>(&from), &fromLen);
+    if(len < 0 || !_cb){ continue; }
+    AsyncUDPPacket packet{_fd, from, buf, static_cast<size_t>(len)};
+    _cb(packet);
+  }
+}
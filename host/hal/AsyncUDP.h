@@ -0,0 +1,54 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef HAL_ASYNC_UDP_H
+#define HAL_ASYNC_UDP_H
+//Host stand-in for the ESP32 AsyncUDP library over a real UDP socket
+//Like on the ESP32 packets are handed to the callback from a task of their own (a thread here),
+//not from loop()
+//The port is moved by HAL_PORT_OFFSET like WiFiServer's (see WiFi.h)
+#include <Arduino.h>
+#include <WiFi.h>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <netinet/in.h>
+
+class AsyncUDPPacket{
+  public:
+    AsyncUDPPacket(int fd, const sockaddr_in &from, uint8_t *data, size_t len) : _fd(fd), _from(from), _data(data), _len(len){}
+
+    uint8_t* data(){ return _data; }
+    size_t length(){ return _len; }
+    IPAddress remoteIP(){ return IPAddress(_from.sin_addr.s_addr); }
+    uint16_t remotePort(){ return ntohs(_from.sin_port); }
+    size_t reply(const uint8_t *data, size_t len);
+    size_t write(const uint8_t *data, size_t len){ return reply(data, len); }
+  private:
+    int _fd;
+    sockaddr_in _from;
+    uint8_t *_data;
+    size_t _len;
+};
+
+class AsyncUDP{
+  public:
+    using packet_cb_t = std::function<void(AsyncUDPPacket&)>;
+    AsyncUDP() : _fd(-1), _running(false){}
+    ~AsyncUDP(){ close(); }
+    AsyncUDP(const AsyncUDP&) = delete;
+    AsyncUDP& operator=(const AsyncUDP&) = delete;
+
+    bool listen(uint16_t port);
+    bool listen(const IPAddress &addr, uint16_t port){ return listen(port); }
+    void onPacket(packet_cb_t cb){ _cb = cb; }
+    void close();
+    bool connected() const { return _fd >= 0; }
+  private:
+    int _fd;
+    std::atomic<bool> _running;
+    std::thread _thread;
+    packet_cb_t _cb;
+
+    void _run();
+};
+#endif //HAL_ASYNC_UDP_H
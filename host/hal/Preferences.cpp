@@ -0,0 +1,128 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#include <Preferences.h>
+
+namespace{
+  const size_t MAX_KEY_LEN = 15; //NVS's limit
+};
+
+std::vector<Preferences::Entry>& Preferences::_entries(){
+  static std::vector<Entry> entries;
+  static bool loaded = false;
+  if(!loaded){ //From the file named by HAL_PREFS, one "namespace key type hex" line per value ("-" when empty)
+    loaded = true;
+    const char *path = getenv("HAL_PREFS");
+    FILE *file = path != nullptr ? fopen(path, "r") : nullptr;
+    if(file != nullptr){
+      char space[32], key[32], hex[8192];
+      int type;
+      while(fscanf(file, "%31s %31s %d %8191s", space, key, &type, hex) == 4){
+        Entry entry{space, key, static_cast<PreferenceType>(type), {}};
+        for(size_t i = 0; hex[0] != '-' && hex[i] != '\0' && hex[i + 1] != '\0'; i += 2){
+          unsigned byte;
+          sscanf(hex + i, "%2x", &byte);
+          entry.value.push_back(byte);
+        }
+        entries.push_back(entry);
+      }
+      fclose(file);
+    }
+  }
+  return entries;
+}
+
+bool Preferences::begin(const char *name, bool readOnly, const char *partition){
+  if(name == nullptr || strlen(name) > MAX_KEY_LEN){ return false; }
+  _space = name;
+  _readOnly = readOnly;
+  _open = true;
+  _entries();
+  return true;
+}
+
+Preferences::Entry* Preferences::_find(const char *key){
+  if(!_open || key == nullptr){ return nullptr; }
+  for(Entry &entry : _entries()){
+    if(entry.space == _space && entry.key == key){ return &entry; }
+  }
+  return nullptr;
+}
+
+bool Preferences::isKey(const char *key){ return _find(key) != nullptr; }
+
+PreferenceType Preferences::getType(const char *key){
+  Entry *entry = _find(key);
+  return entry == nullptr ? PT_INVALID : entry->type;
+}
+
+bool Preferences::remove(const char *key){
+  if(!_open || _readOnly){ return false; }
+  std::vector<Entry> &entries = _entries();
+  for(size_t i = 0; i < entries.size(); ++i){
+    if(entries[i].space == _space && entries[i].key == key){
+      entries.erase(entries.begin() + i);
+      _save();
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Preferences::clear(){
+  if(!_open || _readOnly){ return false; }
+  std::vector<Entry> &entries = _entries();
+  for(size_t i = entries.size(); i-- > 0;){
+    if(entries[i].space == _space){ entries.erase(entries.begin() + i); }
+  }
+  _save();
+  return true;
+}
+
+String Preferences::getString(const char *key, const String &defaultValue){
+  Entry *entry = _find(key);
+  if(entry == nullptr || entry->type != PT_STR){ return defaultValue; }
+  String value;
+  value.concat(reinterpret_cast<const char*>(entry->value.data()), entry->value.size());
+  return value;
+}
+
+size_t Preferences::getBytesLength(const char *key){
+  Entry *entry = _find(key);
+  return entry == nullptr || entry->type != PT_BLOB ? 0 : entry->value.size();
+}
+
+size_t Preferences::getBytes(const char *key, void *buf, size_t maxLen){
+  Entry *entry = _find(key);
+  if(entry == nullptr || entry->type != PT_BLOB || entry->value.size() > maxLen){ return 0; }
+  memcpy(buf, entry->value.data(), entry->value.size());
+  return entry->value.size();
+}
+
+size_t Preferences::_put(const char *key, PreferenceType type, const void *value, size_t len){
+  if(!_open || _readOnly || key == nullptr || strlen(key) > MAX_KEY_LEN){ return 0; }
+  Entry *entry = _find(key);
+  if(entry == nullptr){
+    _entries().push_back({_space, key, type, {}});
+    entry = &_entries().back();
+  }
+  const uint8_t *bytes = static_cast<const uint8_t*>(value);
+  entry->type = type;
+  entry->value.assign(bytes, bytes + len);
+  ++_writes;
+  _save();
+  return len;
+}
+
+void Preferences::_save(){
+  const char *path = getenv("HAL_PREFS");
+  if(path == nullptr){ return; }
+  FILE *file = fopen(path, "w");
+  if(file == nullptr){ return; }
+  for(const Entry &entry : _entries()){
+    fprintf(file, "%s %s %d ", entry.space.c_str(), entry.key.c_str(), entry.type);
+    if(entry.value.empty()){ fputc('-', file); }
+    for(uint8_t byte : entry.value){ fprintf(file, "%02x", byte); }
+    fputc('\n', file);
+  }
+  fclose(file);
+}
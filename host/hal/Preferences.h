@@ -0,0 +1,68 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef HAL_PREFERENCES_H
+#define HAL_PREFERENCES_H
+//Host stand-in for the ESP32 Preferences (NVS) library
+//Values are kept in memory, and in the file named by HAL_PREFS when it is set so they survive a restart
+//Like NVS a value read back as another type than it was written with gives the default
+#include <Arduino.h>
+#include <vector>
+
+typedef enum{
+  PT_I8, PT_U8, PT_I16, PT_U16, PT_I32, PT_U32, PT_I64, PT_U64, PT_STR, PT_BLOB, PT_INVALID
+} PreferenceType;
+
+class Preferences{
+  public:
+    Preferences() : _open(false), _readOnly(false){}
+    ~Preferences(){ end(); }
+
+    bool begin(const char *name, bool readOnly = false, const char *partition = nullptr);
+    void end(){ _open = false; }
+    bool clear();
+    bool remove(const char *key);
+    bool isKey(const char *key);
+    PreferenceType getType(const char *key);
+
+    size_t putUShort(const char *key, uint16_t value){ return _put(key, PT_U16, &value, sizeof(value)); }
+    size_t putUInt(const char *key, uint32_t value){ return _put(key, PT_U32, &value, sizeof(value)); }
+    size_t putULong64(const char *key, uint64_t value){ return _put(key, PT_U64, &value, sizeof(value)); }
+    size_t putString(const char *key, const String &value){ return _put(key, PT_STR, value.c_str(), value.length()); }
+    size_t putString(const char *key, const char *value){ return _put(key, PT_STR, value, strlen(value)); }
+    size_t putBytes(const char *key, const void *value, size_t len){ return _put(key, PT_BLOB, value, len); }
+
+    uint16_t getUShort(const char *key, uint16_t defaultValue = 0){ return _get(key, PT_U16, defaultValue); }
+    uint32_t getUInt(const char *key, uint32_t defaultValue = 0){ return _get(key, PT_U32, defaultValue); }
+    uint64_t getULong64(const char *key, uint64_t defaultValue = 0){ return _get(key, PT_U64, defaultValue); }
+    String getString(const char *key, const String &defaultValue = String());
+    size_t getBytesLength(const char *key);
+    size_t getBytes(const char *key, void *buf, size_t maxLen);
+
+    uint32_t writes() const { return _writes; } //Puts that reached "flash"
+  private:
+    struct Entry{
+      String space;
+      String key;
+      PreferenceType type;
+      std::vector<uint8_t> value;
+    };
+    String _space;
+    bool _open;
+    bool _readOnly;
+    uint32_t _writes = 0;
+
+    static std::vector<Entry>& _entries(); //Shared by every instance like the NVS partition
+    Entry* _find(const char *key);
+    size_t _put(const char *key, PreferenceType type, const void *value, size_t len);
+    void _save();
+
+    template<typename T>
+    T _get(const char *key, PreferenceType type, T defaultValue){
+      Entry *entry = _find(key);
+      if(entry == nullptr || entry->type != type || entry->value.size() != sizeof(T)){ return defaultValue; }
+      T value;
+      memcpy(&value, entry->value.data(), sizeof(T));
+      return value;
+    }
+};
+#endif //HAL_PREFERENCES_H
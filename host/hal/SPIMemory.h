@@ -0,0 +1,45 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef HAL_SPI_MEMORY_H
+#define HAL_SPI_MEMORY_H
+//Host stand-in for the SPIMemory library, a flash chip kept in memory (erased to 0xFF)
+//Like the real chip a write can only clear bits, the sector has to be erased to set them again
+#include <Arduino.h>
+#include <vector>
+#include <algorithm>
+
+class SPIFlash{
+  public:
+    static const uint32_t SECTOR_BYTES = 4096;
+    explicit SPIFlash(uint8_t cs = 5, uint32_t capacity = 1024 * 1024) : _mem(capacity, 0xFF){}
+
+    bool begin(){ return true; }
+    uint32_t getCapacity() const { return _mem.size(); }
+    bool eraseSector(uint32_t addr){
+      if(addr >= _mem.size()){ return false; }
+      addr -= addr % SECTOR_BYTES;
+      memset(_mem.data() + addr, 0xFF, SECTOR_BYTES);
+      return true;
+    }
+    bool eraseChip(){
+      std::fill(_mem.begin(), _mem.end(), 0xFF);
+      return true;
+    }
+    bool readByteArray(uint32_t addr, uint8_t *data, size_t len){
+      if(addr + len > _mem.size()){ return false; }
+      memcpy(data, _mem.data() + addr, len);
+      return true;
+    }
+    bool writeByteArray(uint32_t addr, const uint8_t *data, size_t len){
+      if(addr + len > _mem.size()){ return false; }
+      for(size_t i = 0; i < len; ++i){ _mem[addr + i] &= data[i]; }
+      return true;
+    }
+    template<typename T>
+    bool readAnything(uint32_t addr, T &value){ return readByteArray(addr, reinterpret_cast<uint8_t*>(&value), sizeof(T)); }
+    template<typename T>
+    bool writeAnything(uint32_t addr, const T &value){ return writeByteArray(addr, reinterpret_cast<const uint8_t*>(&value), sizeof(T)); }
+  private:
+    std::vector<uint8_t> _mem;
+};
+#endif //HAL_SPI_MEMORY_H
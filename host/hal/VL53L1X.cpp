@@ -0,0 +1,85 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#include <VL53L1X.h>
+#include <vector>
+
+namespace{
+  const uint16_t DEFAULT_MM = 4000;
+
+  struct TracePoint{
+    unsigned long ms;
+    uint16_t mm;
+  };
+
+  Hal::distance_fn_t source = nullptr;
+
+  //Distance from the trace (or HAL_TOF_MM) at ms
+  uint16_t fromTrace(unsigned long ms){
+    static std::vector<TracePoint> trace;
+    static bool loop = false;
+    static uint16_t fixed = DEFAULT_MM;
+    static bool loaded = false;
+    if(!loaded){
+      loaded = true;
+      const char *mm = getenv("HAL_TOF_MM");
+      if(mm != nullptr){ fixed = atoi(mm); }
+      loop = getenv("HAL_TOF_LOOP") != nullptr;
+      const char *path = getenv("HAL_TOF_TRACE");
+      FILE *file = path != nullptr ? fopen(path, "r") : nullptr;
+      if(path != nullptr && file == nullptr){ perror("HAL_TOF_TRACE"); }
+      if(file != nullptr){
+        char line[128];
+        while(fgets(line, sizeof(line), file) != nullptr){
+          TracePoint point;
+          if(line[0] == '#' || sscanf(line, "%lu %hu", &point.ms, &point.mm) != 2){ continue; }
+          trace.push_back(point);
+        }
+        fclose(file);
+      }
+    }
+    if(trace.empty() || ms < trace[0].ms){ return fixed; }
+    if(loop && trace.back().ms > 0){ ms %= trace.back().ms + 1; }
+    size_t i = 0;
+    while(i + 1 < trace.size() && trace[i + 1].ms <= ms){ ++i; }
+    return trace[i].mm;
+  }
+};
+
+namespace Hal{
+  void setDistanceSource(distance_fn_t fn){ source = fn; }
+};
+
+bool VL53L1X::init(bool io2v8){
+  _running = false;
+  ranging_data = {0, None, 0, 0};
+  return true;
+}
+
+void VL53L1X::startContinuous(uint32_t periodMs){
+  _period = periodMs * 1000 > _budget ? periodMs * 1000 : _budget;
+  _running = true;
+  _nextReady = micros() + _budget;
+}
+
+bool VL53L1X::dataReady(){ return _running && static_cast<long>(micros() - _nextReady) >= 0; }
+
+uint16_t VL53L1X::read(bool blocking){
+  if(blocking){
+    while(_running && !dataReady()){ delayMicroseconds(_nextReady - micros()); }
+  }
+  _nextReady += _period;
+  if(static_cast<long>(micros() - _nextReady) > 0){ _nextReady = micros() + _period; } //Missed measurements aren't queued up
+  return _measure();
+}
+
+uint16_t VL53L1X::readSingle(bool blocking){
+  if(blocking){ delayMicroseconds(_budget); }
+  return _measure();
+}
+
+uint16_t VL53L1X::_measure(){
+  unsigned long ms = millis();
+  ranging_data.range_mm = source != nullptr ? source(ms) : fromTrace(ms);
+  ranging_data.range_status = RangeValid;
+  return ranging_data.range_mm;
+}
@@ -0,0 +1,67 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef HAL_VL53L1X_H
+#define HAL_VL53L1X_H
+//Host stand-in for Pololu's VL53L1X driver
+//Readings become ready once per measurement period like the sensor's, the distance they give comes from
+//  a function set with Hal::setDistanceSource() (a scripted scene), or else
+//  the trace file named by HAL_TOF_TRACE, lines of "ms mm" held until the next line's ms
+//  (replayed from the start when HAL_TOF_LOOP is set), or else
+//  HAL_TOF_MM, 4000 (nothing in front of it) when that isn't set either
+#include <Arduino.h>
+#include <Wire.h>
+
+namespace Hal{
+  using distance_fn_t = uint16_t (*)(unsigned long ms);
+  void setDistanceSource(distance_fn_t fn); //nullptr goes back to the trace
+};
+
+class VL53L1X{
+  public:
+    enum DistanceMode{ Short, Medium, Long, Unknown };
+    enum RangeStatus : uint8_t{ RangeValid = 0, None = 255 };
+    struct RangingData{
+      uint16_t range_mm;
+      RangeStatus range_status;
+      float peak_signal_count_rate_MCPS;
+      float ambient_count_rate_MCPS;
+    };
+    RangingData ranging_data = {0, None, 0, 0};
+
+    VL53L1X() : _mode(Long), _budget(50000), _period(0), _running(false), _nextReady(0){}
+
+    void setBus(TwoWire *bus){}
+    void setAddress(uint8_t address){}
+    void setTimeout(uint16_t timeout){}
+    bool timeoutOccurred(){ return false; }
+    bool init(bool io2v8 = true);
+    bool setDistanceMode(DistanceMode mode){
+      if(mode == Unknown){ return false; }
+      _mode = mode;
+      return true;
+    }
+    DistanceMode getDistanceMode(){ return _mode; }
+    bool setMeasurementTimingBudget(uint32_t budget){
+      if(budget < 20000){ return false; } //Shortest the sensor takes in long mode
+      _budget = budget;
+      return true;
+    }
+    uint32_t getMeasurementTimingBudget(){ return _budget; }
+    void setROISize(uint8_t width, uint8_t height){}
+    void setROICenter(uint8_t spadNumber){}
+
+    void startContinuous(uint32_t periodMs);
+    void stopContinuous(){ _running = false; }
+    bool dataReady();
+    uint16_t read(bool blocking = true);
+    uint16_t readSingle(bool blocking = true);
+  private:
+    DistanceMode _mode;
+    uint32_t _budget; //us
+    uint32_t _period; //us between measurements
+    bool _running;
+    unsigned long _nextReady; //micros() the next reading is ready at
+
+    uint16_t _measure();
+};
+#endif //HAL_VL53L1X_H
@@ -0,0 +1,187 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#include <WiFi.h>
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+WiFiClass WiFi;
+
+namespace{
+  const int WRITE_TIMEOUT = 3000; //ms a write waits for room in the socket, the ESP32's default
+
+  void setNonBlocking(int fd){ fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK); }
+};
+
+namespace Hal{
+  uint16_t hostPort(uint16_t port){
+    const char *offset = getenv("HAL_PORT_OFFSET");
+    return port + (offset != nullptr ? atoi(offset) : 8000);
+  }
+
+  uint32_t bindAddr(){
+    IPAddress addr{127, 0, 0, 1};
+    const char *bind = getenv("HAL_BIND");
+    if(bind != nullptr){ addr.fromString(bind); }
+    return addr;
+  }
+};
+
+void WiFiClass::stationSeen(uint32_t ip){
+  if(std::find(_stations.begin(), _stations.end(), ip) != _stations.end()){ return; }
+  _stations.push_back(ip);
+  if(_cb != nullptr){ _cb(ARDUINO_EVENT_WIFI_AP_STACONNECTED); }
+}
+
+WiFiClient::Socket::~Socket(){ close(fd); }
+
+WiFiClient::WiFiClient(int fd) : _socket(std::make_shared<Socket>(fd)){}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port){
+  stop();
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if(fd < 0){ return 0; }
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = ip;
+  setNonBlocking(fd);
+  if(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 && errno != EINPROGRESS){
+    close(fd);
+    return 0;
+  }
+  pollfd pfd{fd, POLLOUT, 0};
+  int err = 0;
+  socklen_t errLen = sizeof(err);
+  if(poll(&pfd, 1, _timeout) != 1 || getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &errLen) < 0 || err != 0){
+    close(fd);
+    return 0;
+  }
+  _socket = std::make_shared<Socket>(fd);
+  return 1;
+}
+
+uint8_t WiFiClient::connected(){
+  if(!_socket){ return 0; }
+  uint8_t c;
+  int res = recv(fd(), &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  if(res > 0){ return 1; }
+  if(res == 0){ return 0; } //Closed by the other end
+  return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+int WiFiClient::available(){
+  if(!_socket){ return 0; }
+  int count = 0;
+  if(ioctl(fd(), FIONREAD, &count) < 0){ return 0; }
+  return count;
+}
+
+int WiFiClient::read(){
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t *buf, size_t len){
+  if(!_socket){ return -1; }
+  int res = recv(fd(), buf, len, MSG_DONTWAIT);
+  if(res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){ return 0; }
+  return res;
+}
+
+int WiFiClient::peek(){
+  if(!_socket){ return -1; }
+  uint8_t c;
+  return recv(fd(), &c, 1, MSG_PEEK | MSG_DONTWAIT) == 1 ? c : -1;
+}
+
+size_t WiFiClient::write(const uint8_t *data, size_t len){
+  if(!_socket){ return 0; }
+  size_t sent = 0;
+  while(sent < len){
+    ssize_t res = send(fd(), data + sent, len - sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if(res > 0){
+      sent += res;
+      continue;
+    }
+    if(res < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR){ break; }
+    pollfd pfd{fd(), POLLOUT, 0};
+    if(poll(&pfd, 1, WRITE_TIMEOUT) != 1){ break; }
+  }
+  return sent;
+}
+
+void WiFiClient::flush(){
+  uint8_t buf[256];
+  while(read(buf, sizeof(buf)) > 0){}
+}
+
+void WiFiClient::stop(){ _socket.reset(); }
+
+int WiFiClient::setNoDelay(bool noDelay){
+  int flag = noDelay;
+  return setsockopt(fd(), IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+}
+
+IPAddress WiFiClient::remoteIP() const {
+  sockaddr_in addr{};
+  socklen_t len = sizeof(addr);
+  if(!_socket || getpeername(fd(), reinterpret_cast<sockaddr*>(&addr), &len) < 0){ return IPAddress(); }
+  return IPAddress(addr.sin_addr.s_addr);
+}
+
+uint16_t WiFiClient::remotePort() const {
+  sockaddr_in addr{};
+  socklen_t len = sizeof(addr);
+  if(!_socket || getpeername(fd(), reinterpret_cast<sockaddr*>(&addr), &len) < 0){ return 0; }
+  return ntohs(addr.sin_port);
+}
+
+void WiFiServer::begin(uint16_t port){
+  if(_fd >= 0){ return; }
+  if(port != 0){ _port = port; }
+  _fd = socket(AF_INET, SOCK_STREAM, 0);
+  if(_fd < 0){ return; }
+  int reuse = 1;
+  setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(Hal::hostPort(_port));
+  addr.sin_addr.s_addr = Hal::bindAddr();
+  if(bind(_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(_fd, _maxClients) < 0){
+    perror("WiFiServer");
+    end();
+    return;
+  }
+  setNonBlocking(_fd);
+}
+
+void WiFiServer::end(){
+  if(_accepted >= 0){ close(_accepted); }
+  if(_fd >= 0){ close(_fd); }
+  _accepted = -1;
+  _fd = -1;
+}
+
+bool WiFiServer::hasClient(){
+  if(_accepted >= 0){ return true; }
+  if(_fd < 0){ return false; }
+  _accepted = ::accept(_fd, nullptr, nullptr);
+  return _accepted >= 0;
+}
+
+WiFiClient WiFiServer::accept(){
+  if(!hasClient()){ return WiFiClient(); }
+  int fd = _accepted;
+  _accepted = -1;
+  setNonBlocking(fd);
+  WiFiClient client{fd};
+  WiFi.stationSeen(client.remoteIP());
+  return client;
+}
@@ -0,0 +1,114 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef HAL_WIFI_H
+#define HAL_WIFI_H
+//Host stand-in for the ESP32 WiFi library
+//WiFiServer and WiFiClient are real TCP sockets, the radio is always "up"
+//Servers listen on their port plus HAL_PORT_OFFSET (default 8000) so they don't need root,
+//on HAL_BIND (default 127.0.0.1)
+#include <Arduino.h>
+#include <memory>
+#include <vector>
+
+namespace Hal{
+  uint16_t hostPort(uint16_t port); //Port a firmware port is served on
+  uint32_t bindAddr(); //Address servers listen on, network order
+};
+
+//Copies share the socket like the ESP32's, it is closed when the last one lets go of it
+class WiFiClient : public Stream{
+  public:
+    WiFiClient(){}
+    explicit WiFiClient(int fd);
+
+    int connect(IPAddress ip, uint16_t port);
+    uint8_t connected();
+    int available() override;
+    int read() override;
+    int read(uint8_t *buf, size_t len);
+    int peek() override;
+    using Print::write;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *data, size_t len) override;
+    void flush() override; //Throws away unread input like the ESP32's
+    void stop();
+    int setNoDelay(bool noDelay);
+    int fd() const { return _socket ? _socket->fd : -1; }
+    IPAddress remoteIP() const;
+    uint16_t remotePort() const;
+
+    explicit operator bool(){ return connected(); }
+    bool operator==(const WiFiClient &other) const { return _socket == other._socket; }
+    bool operator!=(const WiFiClient &other) const { return _socket != other._socket; }
+  private:
+    struct Socket{
+      int fd;
+      explicit Socket(int fd) : fd(fd){}
+      ~Socket();
+    };
+    std::shared_ptr<Socket> _socket;
+};
+
+class WiFiServer{
+  public:
+    WiFiServer(uint16_t port, uint8_t maxClients = 4) : _port(port), _maxClients(maxClients), _fd(-1), _accepted(-1){}
+    ~WiFiServer(){ end(); }
+    WiFiServer(const WiFiServer&) = delete;
+    WiFiServer& operator=(const WiFiServer&) = delete;
+
+    void begin(uint16_t port = 0);
+    void end();
+    bool hasClient();
+    WiFiClient accept();
+    WiFiClient available(){ return accept(); }
+    void setNoDelay(bool noDelay){}
+    explicit operator bool() const { return _fd >= 0; }
+  private:
+    uint16_t _port;
+    uint8_t _maxClients;
+    int _fd;
+    int _accepted; //Taken by hasClient() until accept()
+};
+
+typedef int WiFiEvent_t;
+struct WiFiEventInfo_t{};
+#define ARDUINO_EVENT_WIFI_STA_DISCONNECTED 5
+#define ARDUINO_EVENT_WIFI_AP_STACONNECTED 12
+enum wifi_mode_t{ WIFI_MODE_NULL, WIFI_MODE_STA, WIFI_MODE_AP, WIFI_MODE_APSTA };
+#define WIFI_OFF WIFI_MODE_NULL
+#define WIFI_STA WIFI_MODE_STA
+#define WIFI_AP WIFI_MODE_AP
+#define WIFI_AP_STA WIFI_MODE_APSTA
+enum wl_status_t{ WL_IDLE_STATUS = 0, WL_CONNECTED = 3, WL_DISCONNECTED = 6 };
+
+//Always connected, a client from an address a WiFiServer hasn't seen since softAP() counts as a station joining it
+class WiFiClass{
+  public:
+    using event_cb_t = void (*)(WiFiEvent_t);
+    using event_info_cb_t = void (*)(WiFiEvent_t, WiFiEventInfo_t);
+
+    wifi_mode_t getMode(){ return _mode; }
+    bool mode(wifi_mode_t mode){ _mode = mode; return true; }
+    bool softAP(const String &ssid, const String &pswd){
+      _stations.clear();
+      return true;
+    }
+    IPAddress softAPIP(){ return IPAddress(192, 168, 4, 1); }
+    IPAddress localIP(){ return IPAddress(127, 0, 0, 1); }
+    bool config(IPAddress local, IPAddress gateway, IPAddress subnet, IPAddress dns = IPAddress()){ return true; }
+    bool setAutoReconnect(bool autoReconnect){ return true; }
+    bool disconnect(){ return true; }
+    void begin(){}
+    void begin(const String &ssid, const String &pswd){}
+    wl_status_t status(){ return WL_CONNECTED; }
+    void onEvent(event_cb_t cb){ _cb = cb; }
+    void onEvent(event_info_cb_t cb, WiFiEvent_t event){}
+
+    void stationSeen(uint32_t ip); //Called by WiFiServer for every client
+  private:
+    wifi_mode_t _mode = WIFI_MODE_NULL;
+    event_cb_t _cb = nullptr;
+    std::vector<uint32_t> _stations;
+};
+extern WiFiClass WiFi;
+#endif //HAL_WIFI_H
@@ -0,0 +1,15 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef HAL_WIRE_H
+#define HAL_WIRE_H
+//Host stand-in for the I2C bus, nothing is ever on it (see VL53L1X.h)
+#include <Arduino.h>
+
+class TwoWire{
+  public:
+    bool begin(){ return true; }
+    bool begin(int sda, int scl, uint32_t frequency = 0){ return true; }
+    bool setClock(uint32_t frequency){ return true; }
+};
+extern TwoWire Wire;
+#endif //HAL_WIRE_H
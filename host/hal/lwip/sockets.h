@@ -0,0 +1,13 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef HAL_LWIP_SOCKETS_H
+#define HAL_LWIP_SOCKETS_H
+//lwIP's BSD socket API is the host's own
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif //HAL_LWIP_SOCKETS_H
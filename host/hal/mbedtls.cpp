@@ -0,0 +1,74 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#include <mbedtls/sha1.h>
+#include <mbedtls/base64.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace{
+  uint32_t rotl(uint32_t v, uint8_t bits){ return (v << bits) | (v >> (32 - bits)); }
+
+  void sha1Block(uint32_t state[5], const unsigned char block[64]){
+    uint32_t w[80];
+    for(uint8_t i = 0; i < 16; ++i){
+      w[i] = (block[i * 4] << 24) | (block[i * 4 + 1] << 16) | (block[i * 4 + 2] << 8) | block[i * 4 + 3];
+    }
+    for(uint8_t i = 16; i < 80; ++i){ w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1); }
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+    for(uint8_t i = 0; i < 80; ++i){
+      uint32_t f, k;
+      if(i < 20){ f = (b & c) | (~b & d); k = 0x5A827999; }
+      else if(i < 40){ f = b ^ c ^ d; k = 0x6ED9EBA1; }
+      else if(i < 60){ f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+      else{ f = b ^ c ^ d; k = 0xCA62C1D6; }
+      uint32_t t = rotl(a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = rotl(b, 30);
+      b = a;
+      a = t;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+  }
+};
+
+int mbedtls_sha1(const unsigned char *input, size_t len, unsigned char output[20]){
+  uint32_t state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+  size_t full = len - len % 64;
+  for(size_t i = 0; i < full; i += 64){ sha1Block(state, input + i); }
+  //Last bytes, the 0x80 marker and the bit length, in one or two blocks
+  unsigned char tail[128] = {0};
+  size_t rest = len - full;
+  memcpy(tail, input + full, rest);
+  tail[rest] = 0x80;
+  size_t tailLen = rest + 9 <= 64 ? 64 : 128;
+  uint64_t bits = static_cast<uint64_t>(len) * 8;
+  for(uint8_t i = 0; i < 8; ++i){ tail[tailLen - 1 - i] = bits >> (i * 8); }
+  for(size_t i = 0; i < tailLen; i += 64){ sha1Block(state, tail + i); }
+  for(uint8_t i = 0; i < 20; ++i){ output[i] = state[i / 4] >> (24 - (i % 4) * 8); }
+  return 0;
+}
+
+int mbedtls_base64_encode(unsigned char *dst, size_t dlen, size_t *olen, const unsigned char *src, size_t slen){
+  static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  size_t need = (slen + 2) / 3 * 4 + 1; //With the terminator like mbedtls
+  *olen = need;
+  if(dst == nullptr || dlen < need){ return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL; }
+  size_t out = 0;
+  for(size_t i = 0; i < slen; i += 3){
+    uint32_t v = src[i] << 16;
+    if(i + 1 < slen){ v |= src[i + 1] << 8; }
+    if(i + 2 < slen){ v |= src[i + 2]; }
+    dst[out++] = ALPHABET[(v >> 18) & 0x3F];
+    dst[out++] = ALPHABET[(v >> 12) & 0x3F];
+    dst[out++] = i + 1 < slen ? ALPHABET[(v >> 6) & 0x3F] : '=';
+    dst[out++] = i + 2 < slen ? ALPHABET[v & 0x3F] : '=';
+  }
+  dst[out] = '\0';
+  *olen = out;
+  return 0;
+}
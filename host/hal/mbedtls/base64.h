@@ -0,0 +1,11 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef HAL_MBEDTLS_BASE64_H
+#define HAL_MBEDTLS_BASE64_H
+//The one mbedtls base64 call the firmware makes (WebSocket handshake)
+#include <stddef.h>
+
+#define MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL -0x002A
+
+int mbedtls_base64_encode(unsigned char *dst, size_t dlen, size_t *olen, const unsigned char *src, size_t slen);
+#endif //HAL_MBEDTLS_BASE64_H
@@ -0,0 +1,9 @@
+//Copyright 2026 Treevar
+//All rights reserved
+#ifndef HAL_MBEDTLS_SHA1_H
+#define HAL_MBEDTLS_SHA1_H
+//The one mbedtls SHA-1 call the firmware makes (WebSocket handshake)
+#include <stddef.h>
+
+int mbedtls_sha1(const unsigned char *input, size_t len, unsigned char output[20]);
+#endif //HAL_MBEDTLS_SHA1_H
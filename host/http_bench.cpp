@@ -0,0 +1,417 @@
+//Copyright 2026 Treevar
+//All rights reserved
+//HTTP load test of the web server
+//Each mix keeps conns keep-alive connections busy for the run's duration, every connection sends
+//its next request as soon as the last one is answered, picking the path by the mix's weights
+//Reports throughput, latency percentiles, errors and the firmware's worst loop() time (loopMaxUs) per mix
+//The run is split in LOOP_WINDOWS, loop us is the median of their worst times (a single one can be the OS'
+//doing on a workstation) and loop max us the worst of them
+//With --baseline it fails (exit 1) if a mix got worse than the saved results by more than the tolerance,
+//--save writes the results as a new baseline
+//Usage: http_bench [--server path] [--host ip] [--port n] [--duration ms] [--mix name]
+//                  [--baseline file] [--save file] [--tolerance percent]
+//  --server starts that build of the firmware (car_stop_bench) for the run and stops it after,
+//  otherwise host and port (a unit is 192.168.4.1 80) have to point at a running one
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+namespace{
+  using Clock = std::chrono::steady_clock;
+
+  const char *HOST_HEADER = "stop.light";
+  const int IO_TIMEOUT_MS = 5000;
+  const uint16_t BENCH_PORT_OFFSET = 9000; //Away from a car_stop_host that may be running (see hal/WiFi.h)
+  const unsigned LOOP_WINDOWS = 3;
+
+  struct Target{
+    const char *method;
+    const char *path;
+    uint8_t weight;
+  };
+  //The page loads / then /getall, polls /get and /getall?since= and sends /set when a setting changes
+  //At most 3 connections, the server takes 4 (WebServer::MAX_CONNECTIONS) and one reads loopMaxUs
+  struct Mix{
+    const char *name;
+    uint8_t conns;
+    std::vector<Target> targets;
+  };
+  const Mix MIXES[] = {
+    {"browse", 2, {{"GET", "/", 4}, {"GET", "/getall", 4}, {"GET", "/get?dp=distance", 2}}},
+    {"poll", 3, {{"GET", "/get?dp=distance", 6}, {"GET", "/getall?since=1", 3}, {"GET", "/getall", 1}}},
+    {"settings", 2, {{"POST", "/set?dp=color&val=16711680", 5}, {"GET", "/get?dp=color", 5}}},
+    {"mixed", 3, {{"GET", "/", 1}, {"GET", "/get?dp=distance", 5}, {"GET", "/getall", 2}, {"POST", "/set?dp=color&val=255", 2}}}
+  };
+
+  struct Result{
+    std::string mix;
+    unsigned conns = 0;
+    double rps = 0;
+    double p50 = 0, p90 = 0, p99 = 0, max = 0; //ms
+    double errorPct = 0;
+    unsigned requests = 0;
+    unsigned errors = 0;
+    long loopUs = -1; //-1 if it couldn't be read
+    long loopMaxUs = -1;
+  };
+
+  //Blocking keep-alive connection that reads whole responses
+  class Connection{
+    public:
+      ~Connection(){ close(); }
+      bool open(const sockaddr_in &addr){
+        close();
+        _fd = socket(AF_INET, SOCK_STREAM, 0);
+        if(_fd < 0){ return false; }
+        timeval tv{IO_TIMEOUT_MS / 1000, (IO_TIMEOUT_MS % 1000) * 1000};
+        setsockopt(_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(_fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        int flag = 1;
+        setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+        if(connect(_fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0){
+          close();
+          return false;
+        }
+        _len = _pos = 0;
+        return true;
+      }
+      void close(){
+        if(_fd >= 0){ ::close(_fd); }
+        _fd = -1;
+      }
+      bool isOpen() const { return _fd >= 0; }
+
+      //Sends the request and reads the response, returns the status code or -1 if the connection failed
+      //keepAlive is set to whether the server left the connection open
+      int request(const char *method, const char *path, bool &keepAlive, std::string *body = nullptr){
+        char req[512];
+        int len = snprintf(req, sizeof(req), "%s %s HTTP/1.1\r\nHost: %s\r\nAccept-Encoding: gzip\r\nContent-Length: 0\r\n\r\n", method, path, HOST_HEADER);
+        if(send(_fd, req, len, MSG_NOSIGNAL) != len){ return -1; }
+        std::string line;
+        if(!_readLine(line) || line.compare(0, 5, "HTTP/") != 0 || line.size() < 12){ return -1; }
+        int status = atoi(line.c_str() + 9);
+        long length = -1;
+        bool chunked = false;
+        keepAlive = line.compare(0, 8, "HTTP/1.1") == 0;
+        while(true){
+          if(!_readLine(line)){ return -1; }
+          if(line.empty()){ break; }
+          if(strncasecmp(line.c_str(), "Content-Length:", 15) == 0){ length = atol(line.c_str() + 15); }
+          else if(strncasecmp(line.c_str(), "Transfer-Encoding:", 18) == 0){ chunked = line.find("chunked") != std::string::npos; }
+          else if(strncasecmp(line.c_str(), "Connection:", 11) == 0){ keepAlive = line.find("close") == std::string::npos; }
+        }
+        if(status == 304 || status == 204 || (status >= 100 && status < 200)){ length = 0; }
+        if(chunked){
+          while(true){
+            if(!_readLine(line)){ return -1; }
+            long size = strtol(line.c_str(), nullptr, 16);
+            if(size == 0){ return _readLine(line) ? status : -1; }
+            if(!_readBody(size, body) || !_readLine(line)){ return -1; }
+          }
+        }
+        if(length < 0){ //Ends when the server closes
+          keepAlive = false;
+          while(_fill()){ _take(_len - _pos, body); }
+          return status;
+        }
+        return _readBody(length, body) ? status : -1;
+      }
+    private:
+      int _fd = -1;
+      char _buf[4096];
+      size_t _len = 0;
+      size_t _pos = 0;
+
+      bool _fill(){
+        if(_pos < _len){ return true; }
+        ssize_t n = recv(_fd, _buf, sizeof(_buf), 0);
+        if(n <= 0){ return false; }
+        _len = n;
+        _pos = 0;
+        return true;
+      }
+      void _take(size_t n, std::string *body){
+        if(body != nullptr){ body->append(_buf + _pos, n); }
+        _pos += n;
+      }
+      bool _readLine(std::string &line){
+        line.clear();
+        while(_fill()){
+          char c = _buf[_pos++];
+          if(c == '\n'){
+            if(!line.empty() && line.back() == '\r'){ line.pop_back(); }
+            return true;
+          }
+          line += c;
+        }
+        return false;
+      }
+      bool _readBody(long length, std::string *body){
+        while(length > 0){
+          if(!_fill()){ return false; }
+          size_t n = std::min<size_t>(length, _len - _pos);
+          _take(n, body);
+          length -= n;
+        }
+        return true;
+      }
+  };
+
+  double percentile(const std::vector<uint32_t> &sorted, double p){
+    if(sorted.empty()){ return 0; }
+    size_t idx = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[idx] / 1000.0;
+  }
+
+  //One request on its own connection, for reading and resetting loopMaxUs
+  int oneShot(const sockaddr_in &addr, const char *method, const char *path, std::string *body){
+    Connection conn;
+    bool keepAlive;
+    return conn.open(addr) ? conn.request(method, path, keepAlive, body) : -1;
+  }
+
+  //Reads loopMaxUs and starts it over, returns -1 if it couldn't be read
+  //conn is kept open through the run, a new connection would take a worker's slot on the server
+  //A server that closes every connection (firmware from before keep-alive) gets a new one for the reset
+  long takeLoopMax(Connection &conn, const sockaddr_in &addr){
+    std::string body;
+    bool keepAlive = false;
+    if(!conn.isOpen() && !conn.open(addr)){ return -1; }
+    int status = conn.request("GET", "/get?dp=loopMaxUs", keepAlive, &body);
+    if(!keepAlive){ conn.close(); }
+    if(status == 200 && (conn.isOpen() || conn.open(addr))){
+      conn.request("POST", "/set?dp=loopMaxUs&val=0", keepAlive);
+      if(!keepAlive){ conn.close(); }
+    }
+    return status == 200 ? atol(body.c_str()) : -1;
+  }
+
+  Result runMix(const sockaddr_in &addr, const Mix &mix, unsigned durationMs){
+    Result result;
+    result.mix = mix.name;
+    result.conns = mix.conns;
+    Connection monitor;
+    takeLoopMax(monitor, addr);
+    std::vector<std::vector<uint32_t>> latencies(mix.conns);
+    std::vector<unsigned> errors(mix.conns, 0);
+    unsigned totalWeight = 0;
+    for(const Target &t : mix.targets){ totalWeight += t.weight; }
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = start + std::chrono::milliseconds(durationMs);
+    std::vector<std::thread> threads;
+    for(unsigned i = 0; i < mix.conns; ++i){
+      threads.emplace_back([&, i](){
+        std::mt19937 rng{i + 1};
+        Connection conn;
+        while(Clock::now() < end){
+          unsigned pick = rng() % totalWeight;
+          const Target *target = &mix.targets[0];
+          for(const Target &t : mix.targets){
+            if(pick < t.weight){
+              target = &t;
+              break;
+            }
+            pick -= t.weight;
+          }
+          Clock::time_point sent = Clock::now();
+          bool keepAlive = false;
+          int status = conn.isOpen() || conn.open(addr) ? conn.request(target->method, target->path, keepAlive) : -1;
+          if(status < 200 || status >= 400){
+            ++errors[i];
+            keepAlive = false;
+            if(status < 0){ std::this_thread::sleep_for(std::chrono::milliseconds(10)); } //Don't spin on a refused connect
+          }
+          else{ latencies[i].push_back(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - sent).count()); }
+          if(!keepAlive){ conn.close(); }
+        }
+      });
+    }
+    std::vector<long> loopMax;
+    for(unsigned w = 1; w <= LOOP_WINDOWS; ++w){
+      std::this_thread::sleep_until(start + std::chrono::milliseconds(durationMs * w / LOOP_WINDOWS));
+      long us = takeLoopMax(monitor, addr);
+      if(us >= 0){ loopMax.push_back(us); }
+    }
+    for(std::thread &t : threads){ t.join(); }
+    if(!loopMax.empty()){
+      std::sort(loopMax.begin(), loopMax.end());
+      result.loopUs = loopMax[loopMax.size() / 2];
+      result.loopMaxUs = loopMax.back();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::vector<uint32_t> all;
+    for(unsigned i = 0; i < mix.conns; ++i){
+      all.insert(all.end(), latencies[i].begin(), latencies[i].end());
+      result.errors += errors[i];
+    }
+    std::sort(all.begin(), all.end());
+    result.requests = all.size() + result.errors;
+    result.rps = all.size() / seconds;
+    result.p50 = percentile(all, 0.50);
+    result.p90 = percentile(all, 0.90);
+    result.p99 = percentile(all, 0.99);
+    result.max = all.empty() ? 0 : all.back() / 1000.0;
+    result.errorPct = result.requests == 0 ? 100 : 100.0 * result.errors / result.requests;
+    return result;
+  }
+
+  void printResult(FILE *out, const Result &r){
+    fprintf(out, "%-10s %5u %8.1f %8.1f %8.1f %8.1f %8.1f %7.2f %8ld %12ld\n",
+      r.mix.c_str(), r.conns, r.rps, r.p50, r.p90, r.p99, r.max, r.errorPct, r.loopUs, r.loopMaxUs);
+  }
+
+  void printHeader(FILE *out){
+    fprintf(out, "#%-9s %5s %8s %8s %8s %8s %8s %7s %8s %12s\n", "mix", "conns", "req/s", "p50 ms", "p90 ms", "p99 ms", "max ms", "err %", "loop us", "loop max us");
+  }
+
+  std::vector<Result> loadBaseline(const char *path){
+    std::vector<Result> results;
+    FILE *file = fopen(path, "r");
+    if(file == nullptr){ return results; }
+    char line[256];
+    while(fgets(line, sizeof(line), file) != nullptr){
+      char name[32];
+      Result r;
+      if(line[0] == '#' || sscanf(line, "%31s %u %lf %lf %lf %lf %lf %lf %ld %ld", name, &r.conns, &r.rps, &r.p50, &r.p90, &r.p99, &r.max, &r.errorPct, &r.loopUs, &r.loopMaxUs) != 10){ continue; }
+      r.mix = name;
+      results.push_back(r);
+    }
+    fclose(file);
+    return results;
+  }
+
+  //Prints what got worse than the baseline by more than tolerance (a fraction)
+  //Latencies move in steps of the firmware's LOOP_DELAY so they also get a fixed slack
+  bool compare(const Result &r, const Result &base, double tolerance){
+    const double LATENCY_SLACK_MS = 10;
+    const long LOOP_SLACK_US = 2000;
+    bool ok = true;
+    auto fail = [&](const char *what, double got, double was){
+      printf("REGRESSION %s %s: %.1f (baseline %.1f)\n", r.mix.c_str(), what, got, was);
+      ok = false;
+    };
+    if(r.rps < base.rps * (1 - tolerance)){ fail("req/s", r.rps, base.rps); }
+    if(r.p50 > base.p50 * (1 + tolerance) + LATENCY_SLACK_MS){ fail("p50 ms", r.p50, base.p50); }
+    if(r.p99 > base.p99 * (1 + tolerance) + LATENCY_SLACK_MS){ fail("p99 ms", r.p99, base.p99); }
+    if(r.errorPct > base.errorPct + 1){ fail("err %", r.errorPct, base.errorPct); }
+    if(base.loopUs >= 0 && r.loopUs > base.loopUs * (1 + tolerance) + LOOP_SLACK_US){ fail("loop us", r.loopUs, base.loopUs); }
+    return ok;
+  }
+
+  //Starts the firmware build at path on the bench port, returns its pid
+  pid_t startServer(const char *path){
+    pid_t pid = fork();
+    if(pid != 0){ return pid; }
+    char offset[8];
+    snprintf(offset, sizeof(offset), "%u", BENCH_PORT_OFFSET);
+    setenv("HAL_PORT_OFFSET", offset, 1);
+    unsetenv("HAL_PREFS"); //Don't touch saved settings
+    freopen("/dev/null", "w", stdout);
+    execl(path, path, static_cast<char*>(nullptr));
+    perror(path);
+    _exit(127);
+  }
+};
+
+int main(int argc, char **argv){
+  const char *server = nullptr;
+  const char *host = "127.0.0.1";
+  int port = -1;
+  unsigned durationMs = 3000;
+  const char *only = nullptr;
+  const char *baseline = nullptr;
+  const char *save = nullptr;
+  double tolerance = 0.25;
+  for(int i = 1; i + 1 < argc; i += 2){
+    const char *opt = argv[i];
+    const char *val = argv[i + 1];
+    if(strcmp(opt, "--server") == 0){ server = val; }
+    else if(strcmp(opt, "--host") == 0){ host = val; }
+    else if(strcmp(opt, "--port") == 0){ port = atoi(val); }
+    else if(strcmp(opt, "--duration") == 0){ durationMs = atoi(val); }
+    else if(strcmp(opt, "--mix") == 0){ only = val; }
+    else if(strcmp(opt, "--baseline") == 0){ baseline = val; }
+    else if(strcmp(opt, "--save") == 0){ save = val; }
+    else if(strcmp(opt, "--tolerance") == 0){ tolerance = atof(val) / 100; }
+    else{
+      fprintf(stderr, "Unknown option %s\n", opt);
+      return 2;
+    }
+  }
+  if(port < 0){ port = server != nullptr ? 80 + BENCH_PORT_OFFSET : 8080; }
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  if(inet_pton(AF_INET, host, &addr.sin_addr) != 1){
+    fprintf(stderr, "Bad host %s\n", host);
+    return 2;
+  }
+
+  pid_t pid = -1;
+  if(server != nullptr){
+    pid = startServer(server);
+    //setup() takes a moment (the sensor fills its readings first)
+    Clock::time_point deadline = Clock::now() + std::chrono::seconds(10);
+    while(oneShot(addr, "GET", "/get?dp=uptime", nullptr) != 200){
+      if(Clock::now() > deadline || waitpid(pid, nullptr, WNOHANG) != 0){
+        fprintf(stderr, "%s didn't come up on port %d\n", server, port);
+        kill(pid, SIGKILL);
+        return 1;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+  }
+
+  std::vector<Result> results;
+  printHeader(stdout);
+  for(const Mix &mix : MIXES){
+    if(only != nullptr && strcmp(only, mix.name) != 0){ continue; }
+    results.push_back(runMix(addr, mix, durationMs));
+    printResult(stdout, results.back());
+    fflush(stdout);
+  }
+  if(pid > 0){
+    kill(pid, SIGTERM);
+    waitpid(pid, nullptr, 0);
+  }
+
+  bool ok = true;
+  if(baseline != nullptr){
+    std::vector<Result> base = loadBaseline(baseline);
+    if(base.empty()){ printf("No baseline in %s, nothing compared\n", baseline); }
+    for(const Result &r : results){
+      for(const Result &b : base){
+        if(b.mix == r.mix && !compare(r, b, tolerance)){ ok = false; }
+      }
+    }
+    if(ok && !base.empty()){ printf("Within %.0f%% of %s\n", tolerance * 100, baseline); }
+  }
+  if(save != nullptr){
+    FILE *file = fopen(save, "w");
+    if(file == nullptr){
+      perror(save);
+      return 1;
+    }
+    fprintf(file, "#http_bench baseline, %u ms per mix (regenerate with the bench_baseline target)\n", durationMs);
+    printHeader(file);
+    for(const Result &r : results){ printResult(file, r); }
+    fclose(file);
+    printf("Saved %s\n", save);
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,26 @@
+//Copyright 2026 Treevar
+//All rights reserved
+//Runs the firmware on the host against the emulated HAL (see hal/)
+//setup() once, then loop() until SIGINT/SIGTERM or run-ms have passed
+//Usage: car_stop_host [run-ms]
+//The web server is on 127.0.0.1:8080 and DNS on :8053 (see hal/WiFi.h), requests need "Host: stop.light"
+#include <Arduino.h>
+#include <signal.h>
+#include "car_stop.ino"
+
+namespace{
+  volatile sig_atomic_t stopRequested = 0;
+
+  void onSignal(int sig){ stopRequested = 1; }
+};
+
+int main(int argc, char **argv){
+  unsigned long runMs = argc > 1 ? strtoul(argv[1], nullptr, 10) : 0;
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  signal(SIGPIPE, SIG_IGN); //Writes to a closed socket fail instead
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+  setup();
+  while(!stopRequested && (runMs == 0 || millis() < runMs)){ loop(); }
+  return 0;
+}
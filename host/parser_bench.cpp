@@ -0,0 +1,85 @@
+//Copyright 2026 Treevar
+//All rights reserved
+//Microbenchmark of HttpRequest and Router on the requests the page makes
+//Each request is parsed whole and in the 128 byte reads WebServer does, then routed
+//Usage: parser_bench [iterations]
+#include <Arduino.h>
+#include <chrono>
+#include "inc/HttpRequest.h"
+#include "inc/Router.h"
+
+namespace{
+  using Clock = std::chrono::steady_clock;
+
+  //Headers WebServer and the sketch keep
+  const char *const HEADERS[] = {
+    "Upgrade", "Sec-WebSocket-Key", "Connection", "Content-Length", "Transfer-Encoding",
+    "Accept-Encoding", "If-None-Match", "Accept"
+  };
+  const uint8_t HEADER_COUNT = sizeof(HEADERS) / sizeof(HEADERS[0]);
+
+  struct Case{
+    const char *name;
+    const char *request;
+  };
+  const Case CASES[] = {
+    {"page", "GET / HTTP/1.1\r\nHost: stop.light\r\n"
+      "User-Agent: Mozilla/5.0 (Linux; Android 14; Pixel 8) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/126.0 Mobile Safari/537.36\r\n"
+      "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+      "Accept-Encoding: gzip, deflate\r\nAccept-Language: en-US,en;q=0.9\r\nConnection: keep-alive\r\n"
+      "If-None-Match: \"0123456789abcdef\"\r\nUpgrade-Insecure-Requests: 1\r\n\r\n"},
+    {"get", "GET /get?dp=distance&dp=mode&dp=threshold HTTP/1.1\r\nHost: stop.light\r\nAccept: application/json\r\nConnection: keep-alive\r\n\r\n"},
+    {"set", "POST /set?threshold=1500&color=%23FF8000 HTTP/1.1\r\nHost: stop.light\r\nContent-Length: 0\r\nConnection: keep-alive\r\n\r\n"},
+    {"probe", "GET /generate_204 HTTP/1.1\r\nHost: connectivitycheck.gstatic.com\r\nConnection: close\r\n\r\n"}
+  };
+
+  void noop(Response &res, const HttpRequest &req){}
+
+  //Parses request in reads of chunk bytes, returns whether it parsed
+  bool parse(HttpRequest &req, const char *request, size_t len, size_t chunk){
+    req.reset(HEADERS, HEADER_COUNT);
+    const uint8_t *data = reinterpret_cast<const uint8_t*>(request);
+    for(size_t pos = 0; pos < len;){
+      size_t n = len - pos < chunk ? len - pos : chunk;
+      size_t consumed;
+      HttpRequest::Result res = req.feed(data + pos, n, consumed);
+      pos += consumed;
+      if(res != HttpRequest::Result::NEED_MORE){ return res == HttpRequest::Result::DONE; }
+    }
+    return false;
+  }
+
+  template<typename Fn>
+  double nsPerOp(uint32_t iterations, Fn fn){
+    Clock::time_point start = Clock::now();
+    for(uint32_t i = 0; i < iterations; ++i){ fn(); }
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+  }
+};
+
+int main(int argc, char **argv){
+  uint32_t iterations = argc > 1 ? strtoul(argv[1], nullptr, 10) : 200000;
+  Router router;
+  const char *paths[] = {"/", "/favicon.ico", "/get", "/getall", "/set", "/setmany", "/trycolor", "/history", "/events", "/ws",
+    "/generate_204", "/hotspot-detect.html", "/test/success.html", "/connecttest.txt", "/success.txt", "/canonical.html"};
+  for(const char *path : paths){ router.add({path, noop, WebPath::GET | WebPath::POST}); }
+
+  static HttpRequest req; //Big enough to not belong on the stack
+  printf("%-8s %6s %12s %12s %12s %10s\n", "request", "bytes", "whole ns", "128B ns", "route ns", "MB/s");
+  for(const Case &c : CASES){
+    size_t len = strlen(c.request);
+    if(!parse(req, c.request, len, len)){
+      printf("%s didn't parse\n", c.name);
+      return 1;
+    }
+    volatile bool sink = false;
+    double whole = nsPerOp(iterations, [&](){ sink = parse(req, c.request, len, len); });
+    double chunked = nsPerOp(iterations, [&](){ sink = parse(req, c.request, len, 128); });
+    const WebPath *route;
+    double routed = nsPerOp(iterations, [&](){
+      sink = router.find(req.path(), req.method(), true, route) == Router::Result::FOUND;
+    });
+    printf("%-8s %6zu %12.1f %12.1f %12.1f %10.1f\n", c.name, len, whole, chunked, routed, len / whole * 1000.0);
+  }
+  return 0;
+}
@@ -0,0 +1,135 @@
+//Copyright 2026 Treevar
+//All rights reserved
+//Fuzz harness for HttpRequest
+//Each input is parsed whole and again split into reads whose size comes from its first byte,
+//both have to give the same result and the parsed request has to stay inside the parser's limits
+//Built with HOST_LIBFUZZER it is a libFuzzer target, otherwise it replays the files it is given
+//and then mutates a few valid requests for the number of runs asked for
+//Usage: parser_fuzz [-runs=N] [file...]
+#include <Arduino.h>
+#include <random>
+#include <string>
+#include <vector>
+#include "inc/HttpRequest.h"
+
+namespace{
+  const char *const HEADERS[] = {"Connection", "Content-Length", "Accept-Encoding", "If-None-Match"};
+  const uint8_t HEADER_COUNT = sizeof(HEADERS) / sizeof(HEADERS[0]);
+
+  void check(bool ok, const char *what){
+    if(ok){ return; }
+    fprintf(stderr, "parser_fuzz: %s\n", what);
+    abort();
+  }
+
+  //View has to be inside the request (what the parser stores it in)
+  void checkView(const HttpRequest &req, const StrView &view){
+    if(view.data == nullptr){
+      check(view.len == 0, "null view with a length");
+      return;
+    }
+    const char *begin = reinterpret_cast<const char*>(&req);
+    check(view.data >= begin && view.data + view.len <= begin + sizeof(req), "view outside the request");
+  }
+
+  HttpRequest::Result parse(HttpRequest &req, const uint8_t *data, size_t len, size_t chunk, size_t &used){
+    req.reset(HEADERS, HEADER_COUNT);
+    used = 0;
+    while(used < len){
+      size_t n = len - used < chunk ? len - used : chunk;
+      size_t consumed;
+      HttpRequest::Result res = req.feed(data + used, n, consumed);
+      check(consumed <= n, "consumed more than it was given");
+      check(consumed == n || res != HttpRequest::Result::NEED_MORE, "stopped early without a result");
+      used += consumed;
+      if(res != HttpRequest::Result::NEED_MORE){ return res; }
+    }
+    return HttpRequest::Result::NEED_MORE;
+  }
+};
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size){
+  if(size == 0){ return 0; }
+  static HttpRequest whole;
+  static HttpRequest split;
+  size_t chunk = data[0] % 32 + 1;
+  ++data;
+  --size;
+  size_t wholeUsed, splitUsed;
+  HttpRequest::Result res = parse(whole, data, size, size == 0 ? 1 : size, wholeUsed);
+  check(parse(split, data, size, chunk, splitUsed) == res, "split input gave another result");
+  check(wholeUsed == splitUsed, "split input ended somewhere else");
+  if(res != HttpRequest::Result::DONE){ return 0; }
+
+  check(whole.path().len <= HttpRequest::MAX_BYTES, "path longer than the buffer");
+  check(whole.path().len == split.path().len && memcmp(whole.path().data, split.path().data, whole.path().len) == 0, "paths differ");
+  check(whole.paramCount() <= HttpRequest::MAX_PARAMS, "too many params");
+  check(whole.paramCount() == split.paramCount(), "param counts differ");
+  checkView(whole, whole.path());
+  checkView(whole, whole.host());
+  for(uint8_t i = 0; i < whole.paramCount(); ++i){
+    checkView(whole, whole.paramName(i));
+    checkView(whole, whole.paramValue(i));
+  }
+  for(const char *name : HEADERS){
+    checkView(whole, whole.header(name));
+    check(whole.header(name).len == split.header(name).len, "headers differ");
+  }
+  return 0;
+}
+
+#ifndef HOST_LIBFUZZER
+namespace{
+  const char *const SEEDS[] = {
+    "GET / HTTP/1.1\r\nHost: stop.light\r\nAccept-Encoding: gzip\r\nConnection: keep-alive\r\n\r\n",
+    "GET /get?dp=distance&dp=mode HTTP/1.1\r\nHost: stop.light\r\nIf-None-Match: \"abc\"\r\n\r\n",
+    "POST /set?threshold=1500&color=%23FF8000 HTTP/1.0\r\nContent-Length: 0\r\n\r\n",
+    "GET /generate_204 HTTP/1.1\r\nHost: connectivitycheck.gstatic.com\r\n\r\nGET / HTTP/1.1\r\n\r\n"
+  };
+  //Chars that mean something to the parser, mutations favour them
+  const char SPECIAL[] = " \r\n?&=%:/+0aF";
+
+  std::vector<uint8_t> mutate(std::mt19937 &rng, const char *seed){
+    std::vector<uint8_t> input(seed, seed + strlen(seed));
+    uint32_t edits = rng() % 8 + 1;
+    for(uint32_t i = 0; i < edits; ++i){
+      size_t pos = input.empty() ? 0 : rng() % input.size();
+      uint8_t c = rng() % 2 == 0 ? SPECIAL[rng() % (sizeof(SPECIAL) - 1)] : static_cast<uint8_t>(rng());
+      switch(rng() % 4){
+        case 0: if(!input.empty()){ input[pos] = c; } break;
+        case 1: input.insert(input.begin() + pos, c); break;
+        case 2: if(!input.empty()){ input.erase(input.begin() + pos); } break;
+        case 3: input.insert(input.begin() + pos, rng() % 700, c); break; //Long runs hit the limits
+      }
+    }
+    input.insert(input.begin(), static_cast<uint8_t>(rng()));
+    return input;
+  }
+};
+
+int main(int argc, char **argv){
+  uint32_t runs = 100000;
+  for(int i = 1; i < argc; ++i){
+    if(strncmp(argv[i], "-runs=", 6) == 0){
+      runs = strtoul(argv[i] + 6, nullptr, 10);
+      continue;
+    }
+    FILE *file = fopen(argv[i], "rb");
+    if(file == nullptr){
+      perror(argv[i]);
+      return 1;
+    }
+    std::vector<uint8_t> input;
+    for(int c; (c = fgetc(file)) != EOF;){ input.push_back(c); }
+    fclose(file);
+    LLVMFuzzerTestOneInput(input.data(), input.size());
+  }
+  std::mt19937 rng{12345};
+  for(uint32_t i = 0; i < runs; ++i){
+    std::vector<uint8_t> input = mutate(rng, SEEDS[rng() % (sizeof(SEEDS) / sizeof(SEEDS[0]))]);
+    LLVMFuzzerTestOneInput(input.data(), input.size());
+  }
+  printf("parser_fuzz: %u runs passed\n", runs);
+  return 0;
+}
+#endif //HOST_LIBFUZZER
@@ -0,0 +1,115 @@
+//Copyright 2026 Treevar
+//All rights reserved
+//Compression and encode/decode speed of the raw history samples (inc/SampleLog.h)
+//The samples are a simulated day of the distance sensor as the sketch records it (see recordDistance):
+//  time:  a reading every 101 ms (the sensor's own clock runs a bit off the 100 ms asked for), stamped with the
+//         time of the loop() that picks it up, 0-2 ms later, up to 20 ms while a web request is served,
+//         now and then one is missed
+//  value: an empty garage at 2400 mm with a few mm of noise, a car pulls in every 20-40 minutes, stays a while,
+//         and backs out, now and then a reading is way off (a person walking by)
+//ratio is against the 10 bytes a sample takes packed (8 byte time, 2 byte distance, like the /ws messages)
+//and the 16 bytes of a struct holding one
+//Every decoded sample is checked against the trace, so is decoding from the middle
+//Usage: sample_bench [--hours n] [--seed n]
+#include <Arduino.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "inc/SampleLog.h"
+
+namespace{
+  using Clock = std::chrono::steady_clock;
+
+  const uint16_t BLOCK_BYTES = 128; //History's
+  const uint16_t BLOCKS = 16384; //2 MB, room for a day of samples at 2.4 bytes each
+  const uint8_t PACKED_BYTES = 10;
+  const uint8_t STRUCT_BYTES = 16;
+
+  struct Sample{
+    Time::Time_t time;
+    int32_t value;
+  };
+
+  std::vector<Sample> trace(uint32_t hours, uint32_t seed){
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> loopDelay(0, 2);
+    std::uniform_int_distribution<int> busyDelay(0, 20);
+    std::uniform_real_distribution<double> chance(0, 1);
+    std::normal_distribution<double> noise(0, 3);
+    std::vector<Sample> samples;
+    const double EMPTY_MM = 2400, PARKED_MM = 650;
+    Time::Time_t end = static_cast<Time::Time_t>(hours) * Time::MS_IN_HOUR;
+    Time::Time_t nextCar = 20 * Time::MS_IN_MIN;
+    Time::Time_t carStart = 0, carStay = 0;
+    for(Time::Time_t reading = 5000; reading < end; reading += 101){
+      if(chance(rng) < 0.005){ continue; } //Missed
+      Time::Time_t time = reading + (chance(rng) < 0.05 ? busyDelay(rng) : loopDelay(rng));
+      if(time >= nextCar && carStart < nextCar){
+        carStart = nextCar;
+        carStay = std::uniform_int_distribution<Time::Time_t>(5, 30)(rng) * Time::MS_IN_MIN;
+        nextCar += carStay + std::uniform_int_distribution<Time::Time_t>(20, 40)(rng) * Time::MS_IN_MIN;
+      }
+      double mm = EMPTY_MM;
+      if(time >= carStart && time < carStart + carStay){
+        double in = (time - carStart) / 8000.0, out = (carStart + carStay - time) / 8000.0; //8 s to pull in or out
+        double part = in < 1 ? in : out < 1 ? out : 1;
+        mm = EMPTY_MM - (EMPTY_MM - PARKED_MM) * part;
+      }
+      if(chance(rng) < 0.002){ mm = 300 + chance(rng) * 1500; }
+      samples.push_back({time, static_cast<int32_t>(mm + noise(rng))});
+    }
+    return samples;
+  }
+};
+
+int main(int argc, char **argv){
+  uint32_t hours = 24;
+  uint32_t seed = 1;
+  for(int i = 1; i + 1 < argc; i += 2){
+    if(strcmp(argv[i], "--hours") == 0){ hours = strtoul(argv[i + 1], nullptr, 10); }
+    else if(strcmp(argv[i], "--seed") == 0){ seed = strtoul(argv[i + 1], nullptr, 10); }
+    else{
+      printf("Unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+  std::vector<Sample> samples = trace(hours, seed);
+  static SampleLog<BLOCKS, BLOCK_BYTES> log;
+
+  Clock::time_point start = Clock::now();
+  for(const Sample &s : samples){ log.append(s.time, s.value); }
+  double encodeSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  size_t decoded = 0;
+  size_t wrong = 0;
+  start = Clock::now();
+  log.forEach(0, [&](Time::Time_t time, int32_t value){
+    if(decoded >= samples.size() || samples[decoded].time != time || samples[decoded].value != value){ ++wrong; }
+    ++decoded;
+  });
+  double decodeSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+  if(decoded != samples.size() || wrong > 0){
+    printf("Decoded %zu samples of %zu, %zu wrong (the log holds %zu bytes)\n", decoded, samples.size(), wrong, log.BYTES);
+    return 1;
+  }
+  //From the middle, skipping the blocks before it
+  Time::Time_t from = samples[samples.size() / 2].time;
+  size_t after = 0, fromDecoded = 0;
+  for(const Sample &s : samples){ after += s.time >= from ? 1 : 0; }
+  log.forEach(from, [&](Time::Time_t, int32_t){ ++fromDecoded; });
+  if(fromDecoded != after){
+    printf("Decoded %zu samples from %llu, should be %zu\n", fromDecoded, static_cast<unsigned long long>(from), after);
+    return 1;
+  }
+
+  //Whole blocks, a block's unused end is memory the samples take too
+  size_t bytes = (log.blocksUsed() * BLOCK_BYTES);
+  double perSample = static_cast<double>(bytes) / samples.size();
+  printf("%zu samples, %zu bytes in %u byte blocks\n", samples.size(), bytes, BLOCK_BYTES);
+  printf("%-8s %10s %10s %10s\n", "", "B/sample", "vs packed", "vs struct");
+  printf("%-8s %10.3f %9.2fx %9.2fx\n", "size", perSample, PACKED_BYTES / perSample, STRUCT_BYTES / perSample);
+  printf("%-8s %10s %10s\n", "", "Msample/s", "ns/sample");
+  printf("%-8s %10.1f %10.2f\n", "encode", samples.size() / encodeSeconds / 1e6, encodeSeconds * 1e9 / samples.size());
+  printf("%-8s %10.1f %10.2f\n", "decode", samples.size() / decodeSeconds / 1e6, decodeSeconds * 1e9 / samples.size());
+  return 0;
+}
@@ -1,3 +1,5 @@
 #!/bin/bash
 ./min.sh index.html car_stop/data/main.string
 ./min.sh notFound.html car_stop/data/notFound.string
+./gz.sh car_stop/data/main.string
+./gz.sh car_stop/data/favicon.string